@@ -0,0 +1,90 @@
+// Copyright Milán Amrein
+
+
+#include "AbilitySystem/AuraCombatRandomSubsystem.h"
+#include "AbilitySystemComponent.h"
+#include "AuraAbilityTypes.h"
+#include "Aura/AuraLogChannels.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+
+static int32 GAuraCombatRandomSeed = 0;
+static FAutoConsoleVariableRef CVarAuraCombatRandomSeed(
+	TEXT("Aura.Combat.RandomSeed"),
+	GAuraCombatRandomSeed,
+	TEXT("Base seed of all combat rolls in every World. 0 = random seed per World. Setting it also resets the roll counters, so a session can be replayed exactly."),
+	FConsoleVariableDelegate::CreateLambda([](IConsoleVariable* Variable) {
+		for (TObjectIterator<UAuraCombatRandomSubsystem> It; It; ++It) {
+			It->Reseed(Variable->GetInt());
+		}
+	}),
+	ECVF_Cheat
+);
+
+// Function to hash an Actor by its name instead of its address, so the hash is the same when the session is replayed
+static uint32 GetActorSeedHash(const AActor* Actor)
+{
+	return Actor ? GetTypeHash(Actor->GetName()) : 0;
+}
+
+void UAuraCombatRandomSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Reseed(GAuraCombatRandomSeed);
+}
+
+void UAuraCombatRandomSubsystem::AssignSpecSeed(FGameplayEffectContextHandle& EffectContextHandle)
+{
+	FAuraGameplayEffectContext* AuraEffectContext = static_cast<FAuraGameplayEffectContext*>(EffectContextHandle.Get());
+	if (AuraEffectContext == nullptr || AuraEffectContext->HasCombatSeed()) return;
+
+	// Seeds are counted per Instigator in its World, so other Worlds and other Instigators never shift them
+	const AActor* Instigator = EffectContextHandle.GetOriginalInstigator();
+	const UWorld* World = Instigator ? Instigator->GetWorld() : nullptr;
+	if (UAuraCombatRandomSubsystem* CombatRandom = World ? World->GetSubsystem<UAuraCombatRandomSubsystem>() : nullptr) {
+		AuraEffectContext->SetCombatSeed(CombatRandom->NextSeed(Instigator));
+		return;
+	}
+
+	// Without a World there is nothing to count in, the seed then only depends on the fixed base seed and the Instigator
+	UE_LOG(LogAura, Verbose, TEXT("No combat Random Subsystem for [%s], seeding its Spec from the Instigator only"), *GetNameSafe(Instigator));
+	AuraEffectContext->SetCombatSeed(HashCombine(static_cast<uint32>(GAuraCombatRandomSeed), GetActorSeedHash(Instigator)));
+}
+
+FRandomStream UAuraCombatRandomSubsystem::MakeCombatStream(FGameplayEffectContextHandle& EffectContextHandle, const AActor* Target, EAuraCombatRoll Roll)
+{
+	AssignSpecSeed(EffectContextHandle);
+
+	const FAuraGameplayEffectContext* AuraEffectContext = static_cast<const FAuraGameplayEffectContext*>(EffectContextHandle.Get());
+	const uint32 SpecSeed = AuraEffectContext ? AuraEffectContext->GetCombatSeed() : 0;
+	const uint32 Seed = HashCombine(HashCombine(SpecSeed, GetActorSeedHash(Target)), static_cast<uint32>(Roll));
+	return FRandomStream(static_cast<int32>(Seed));
+}
+
+FRandomStream UAuraCombatRandomSubsystem::MakeCombatStream(const UObject* WorldContextObject, const AActor* Source)
+{
+	const UWorld* World = GEngine ? GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull) : nullptr;
+	if (UAuraCombatRandomSubsystem* CombatRandom = World ? World->GetSubsystem<UAuraCombatRandomSubsystem>() : nullptr) {
+		return FRandomStream(static_cast<int32>(CombatRandom->NextSeed(Source)));
+	}
+
+	UE_LOG(LogAura, Verbose, TEXT("No combat Random Subsystem for [%s], seeding from the Source only"), *GetNameSafe(Source));
+	return FRandomStream(static_cast<int32>(HashCombine(static_cast<uint32>(GAuraCombatRandomSeed), GetActorSeedHash(Source))));
+}
+
+void UAuraCombatRandomSubsystem::Reseed(int32 InSeed)
+{
+	BaseSeed = InSeed != 0 ? static_cast<uint32>(InSeed) : FPlatformTime::Cycles();
+	SeedCountBySource.Reset();
+}
+
+uint32 UAuraCombatRandomSubsystem::NextSeed(const AActor* Source)
+{
+	const uint32 SourceHash = GetActorSeedHash(Source);
+	uint32& SeedCount = SeedCountBySource.FindOrAdd(SourceHash);
+
+	return HashCombine(HashCombine(BaseSeed, SourceHash), SeedCount++);
+}
@@ -0,0 +1,232 @@
+// Copyright Milán Amrein
+
+
+#include "AbilitySystem/AuraDamageEventLog.h"
+#include "Aura/AuraLogChannels.h"
+#include "AuraGameplayTags.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/BufferArchive.h"
+#include "UObject/UObjectArray.h"
+
+static int32 GAuraDamageLogEnabled = 1;
+static FAutoConsoleVariableRef CVarAuraDamageLogEnabled(
+	TEXT("Aura.DamageLog.Enabled"),
+	GAuraDamageLogEnabled,
+	TEXT("Whether or not the server records Damage events into the Damage event ring buffer."),
+	ECVF_Default
+);
+
+// Function to resolve the name of an Actor that is still alive, otherwise fall back to its ID.
+// IDs are reused once an object is destroyed, so the serial number must match as well.
+static FString GetObjectNameOrId(uint32 ObjectId, int32 SerialNumber)
+{
+	const FUObjectItem* ObjectItem = ObjectId != 0 ? GUObjectArray.IndexToObject(ObjectId) : nullptr;
+	if (ObjectItem && ObjectItem->Object && ObjectItem->GetSerialNumber() == SerialNumber) {
+		return ObjectItem->Object->GetFName().ToString();
+	}
+	return FString::Printf(TEXT("%u:%d"), ObjectId, SerialNumber);
+}
+
+void FAuraDamageEventRecord::GetObjectId(const UObject* Object, uint32& OutId, int32& OutSerialNumber)
+{
+	if (!Object) {
+		OutId = 0;
+		OutSerialNumber = 0;
+		return;
+	}
+
+	// Serial numbers are only assigned on demand, after that this is a plain read
+	OutId = Object->GetUniqueID();
+	OutSerialNumber = GUObjectArray.AllocateSerialNumber(OutId);
+}
+
+FArchive& operator<<(FArchive& Ar, FAuraDamageEventRecord& Record)
+{
+	Ar << Record.Timestamp;
+	Ar << Record.SourceId << Record.TargetId;
+	Ar << Record.SourceSerialNumber << Record.TargetSerialNumber;
+	Ar << Record.RawDamage << Record.MitigatedDamage;
+	Ar << Record.DamageTypeIndex << Record.Flags;
+	return Ar;
+}
+
+/**
+ * Console commands of the Damage event log
+ */
+struct FAuraDamageEventLogCommands
+{
+	static void Dump(const TArray<FString>& Args)
+	{
+		// Args: [csv|bin] [FilePath]
+		const bool bBinary = Args.Num() > 0 && Args[0].Equals(TEXT("bin"), ESearchCase::IgnoreCase);
+		const FString Extension = bBinary ? TEXT("bin") : TEXT("csv");
+		const FString FilePath = Args.Num() > 1
+			? Args[1]
+			: FPaths::ProjectSavedDir() / TEXT("DamageLog") / FString::Printf(TEXT("DamageEvents_%s.%s"), *FDateTime::Now().ToString(), *Extension);
+
+		const FAuraDamageEventLog& Log = FAuraDamageEventLog::Get();
+		if (bBinary ? Log.DumpBinary(FilePath) : Log.DumpCsv(FilePath)) {
+			UE_LOG(LogAura, Display, TEXT("Damage events written to [%s]"), *FilePath);
+		}
+		else {
+			UE_LOG(LogAura, Error, TEXT("Failed to write Damage events to [%s]"), *FilePath);
+		}
+	}
+
+	static void Stats()
+	{
+		FAuraDamageEventLog::Get().LogStats();
+	}
+
+	static void Clear()
+	{
+		FAuraDamageEventLog::Get().Clear();
+	}
+};
+
+static FAutoConsoleCommand CmdAuraDamageLogDump(
+	TEXT("Aura.DamageLog.Dump"),
+	TEXT("Writes the buffered Damage events to disk. Usage: Aura.DamageLog.Dump [csv|bin] [FilePath]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&FAuraDamageEventLogCommands::Dump)
+);
+
+static FAutoConsoleCommand CmdAuraDamageLogStats(
+	TEXT("Aura.DamageLog.Stats"),
+	TEXT("Logs hits per second, the mitigation distribution and the Sources dealing the most Damage from the buffered Damage events."),
+	FConsoleCommandDelegate::CreateStatic(&FAuraDamageEventLogCommands::Stats)
+);
+
+static FAutoConsoleCommand CmdAuraDamageLogClear(
+	TEXT("Aura.DamageLog.Clear"),
+	TEXT("Drops all buffered Damage events."),
+	FConsoleCommandDelegate::CreateStatic(&FAuraDamageEventLogCommands::Clear)
+);
+
+FAuraDamageEventLog& FAuraDamageEventLog::Get()
+{
+	static FAuraDamageEventLog DamageEventLog;
+
+	return DamageEventLog;
+}
+
+FAuraDamageEventLog::FAuraDamageEventLog()
+{
+	static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+	Records.SetNum(Capacity);
+}
+
+void FAuraDamageEventLog::Record(const FAuraDamageEventRecord& InRecord)
+{
+	FScopeLock Lock(&RecordsCriticalSection);
+	Records[NumWritten++ & (Capacity - 1)] = InRecord;
+}
+
+void FAuraDamageEventLog::Snapshot(TArray<FAuraDamageEventRecord>& OutRecords) const
+{
+	FScopeLock Lock(&RecordsCriticalSection);
+	const uint64 Written = NumWritten;
+	const int32 NumRecords = static_cast<int32>(FMath::Min<uint64>(Written, Capacity));
+
+	OutRecords.Reset(NumRecords);
+	for (uint64 ReadIndex = Written - NumRecords; ReadIndex < Written; ReadIndex++) {
+		OutRecords.Add(Records[ReadIndex & (Capacity - 1)]);
+	}
+}
+
+void FAuraDamageEventLog::Clear()
+{
+	FScopeLock Lock(&RecordsCriticalSection);
+	NumWritten = 0;
+}
+
+bool FAuraDamageEventLog::IsEnabled()
+{
+	return GAuraDamageLogEnabled != 0;
+}
+
+bool FAuraDamageEventLog::DumpCsv(const FString& FilePath) const
+{
+	TArray<FAuraDamageEventRecord> Snapshot;
+	this->Snapshot(Snapshot);
+
+	const FAuraGameplayTags& GameplayTags = FAuraGameplayTags::Get();
+	FString Csv = TEXT("Timestamp,Source,Target,DamageType,RawDamage,MitigatedDamage,Blocked,Critical,Debuff,Fatal\n");
+	for (const FAuraDamageEventRecord& Event : Snapshot) {
+		const FString SourceName = GetObjectNameOrId(Event.SourceId, Event.SourceSerialNumber);
+		const FString TargetName = GetObjectNameOrId(Event.TargetId, Event.TargetSerialNumber);
+		const FString DamageTypeName = Event.DamageTypeIndex < GameplayTags.DamageTypeTags.Num() ? GameplayTags.DamageTypeTags[Event.DamageTypeIndex].ToString() : TEXT("None");
+
+		Csv += FString::Printf(TEXT("%.6f,%s,%s,%s,%.3f,%.3f,%d,%d,%d,%d\n"),
+			Event.Timestamp, *SourceName, *TargetName, *DamageTypeName, Event.RawDamage, Event.MitigatedDamage,
+			(Event.Flags & FAuraDamageEventRecord::Blocked) != 0,
+			(Event.Flags & FAuraDamageEventRecord::Critical) != 0,
+			(Event.Flags & FAuraDamageEventRecord::Debuff) != 0,
+			(Event.Flags & FAuraDamageEventRecord::Fatal) != 0
+		);
+	}
+
+	return FFileHelper::SaveStringToFile(Csv, *FilePath);
+}
+
+bool FAuraDamageEventLog::DumpBinary(const FString& FilePath) const
+{
+	TArray<FAuraDamageEventRecord> Snapshot;
+	this->Snapshot(Snapshot);
+
+	// Header: magic, version, record count. Always little endian, whatever the server runs on
+	FBufferArchive Archive;
+	Archive.SetByteSwapping(!PLATFORM_LITTLE_ENDIAN);
+	uint32 Magic = 0x41444D47; // "ADMG"
+	uint32 Version = 3; // 1 and 2 were raw struct copies
+	int32 NumRecords = Snapshot.Num();
+	Archive << Magic << Version << NumRecords;
+	for (FAuraDamageEventRecord& Record : Snapshot) {
+		Archive << Record;
+	}
+
+	return FFileHelper::SaveArrayToFile(Archive, *FilePath);
+}
+
+void FAuraDamageEventLog::LogStats() const
+{
+	TArray<FAuraDamageEventRecord> Snapshot;
+	this->Snapshot(Snapshot);
+	if (Snapshot.Num() == 0) {
+		UE_LOG(LogAura, Display, TEXT("Damage log is empty"));
+		return;
+	}
+
+	// Hits per second over the buffered window
+	const double Window = Snapshot.Last().Timestamp - Snapshot[0].Timestamp;
+	const double HitsPerSecond = Window > 0.0 ? Snapshot.Num() / Window : 0.0;
+
+	// Mitigation distribution in 10% buckets, plus Damage dealt by each Source
+	int32 MitigationBuckets[10] = {};
+	int32 NumBlocked = 0;
+	int32 NumCritical = 0;
+	TMap<TPair<uint32, int32>, double> DamageBySource;
+	for (const FAuraDamageEventRecord& Event : Snapshot) {
+		const float Mitigation = Event.RawDamage > 0.f ? 1.f - Event.MitigatedDamage / Event.RawDamage : 0.f;
+		MitigationBuckets[FMath::Clamp(FMath::FloorToInt(Mitigation * 10.f), 0, 9)]++;
+		NumBlocked += (Event.Flags & FAuraDamageEventRecord::Blocked) != 0 ? 1 : 0;
+		NumCritical += (Event.Flags & FAuraDamageEventRecord::Critical) != 0 ? 1 : 0;
+		DamageBySource.FindOrAdd(TPair<uint32, int32>(Event.SourceId, Event.SourceSerialNumber)) += Event.MitigatedDamage;
+	}
+
+	UE_LOG(LogAura, Display, TEXT("Damage log: %d hits over %.2fs (%.1f hits/s), %.1f%% blocked, %.1f%% critical"),
+		Snapshot.Num(), Window, HitsPerSecond, 100.f * NumBlocked / Snapshot.Num(), 100.f * NumCritical / Snapshot.Num());
+	for (int32 Bucket = 0; Bucket < 10; Bucket++) {
+		UE_LOG(LogAura, Display, TEXT("  Mitigation %3d%%-%3d%%: %d"), Bucket * 10, Bucket * 10 + 10, MitigationBuckets[Bucket]);
+	}
+
+	// Hotspots: Sources dealing the most Damage
+	DamageBySource.ValueSort([](double A, double B) { return A > B; });
+	int32 NumListed = 0;
+	for (const TPair<TPair<uint32, int32>, double>& Pair : DamageBySource) {
+		if (NumListed++ >= 5) break;
+		UE_LOG(LogAura, Display, TEXT("  Top Source %s: %.1f Damage"), *GetObjectNameOrId(Pair.Key.Key, Pair.Key.Value), Pair.Value);
+	}
+}
@@ -0,0 +1,236 @@
+// Copyright Milán Amrein
+
+
+#include "AbilitySystem/AuraDoTSubsystem.h"
+#include "AbilitySystemComponent.h"
+#include "AbilitySystem/AuraAbilitySystemLibrary.h"
+#include "AbilitySystem/AuraAttributeSet.h"
+#include "AuraGameplayTags.h"
+#include "Aura/AuraLogChannels.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommandWithWorld CmdAuraDebuffStats(
+	TEXT("Aura.Debuff.Stats"),
+	TEXT("Logs the active Debuff Effects and stacks of every debuffed Target, e.g. under sustained beam Damage."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World) {
+		if (const UAuraDoTSubsystem* DoTSubsystem = World ? World->GetSubsystem<UAuraDoTSubsystem>() : nullptr) {
+			DoTSubsystem->LogDebuffStats();
+		}
+	})
+);
+#endif
+
+bool UAuraDoTSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// DoTs are only added by the server's AttributeSet. Clients that already have their Net Driver are left out here,
+	// the others only know their Net Mode once play begins
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld() && World->GetNetMode() != NM_Client && Super::ShouldCreateSubsystem(Outer);
+}
+
+void UAuraDoTSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	bIsServerWorld = InWorld.GetNetMode() != NM_Client;
+}
+
+TStatId UAuraDoTSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAuraDoTSubsystem, STATGROUP_Tickables);
+}
+
+void UAuraDoTSubsystem::AddDoT(UAbilitySystemComponent* SourceASC, UAbilitySystemComponent* TargetASC, FActiveGameplayEffectHandle DebuffHandle, const FGameplayTag& DamageType, float Damage, float Period, float Duration)
+{
+	if (!bIsServerWorld || TargetASC == nullptr || Damage <= 0.f) return;
+
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	// A refreshed Debuff stack keeps its Handle, extend the existing DoT instead of adding a second one.
+	// It keeps ticking on its own Period, so re-applying faster than the Period never deals extra ticks.
+	FAuraDoTEntry* Entry = DoTs.FindByPredicate([&DebuffHandle](const FAuraDoTEntry& DoT) {
+		return DebuffHandle.IsValid() && DoT.DebuffHandle == DebuffHandle;
+	});
+	if (Entry) {
+		Entry->SourceASC = SourceASC;
+		Entry->Damage = Damage;
+		Entry->EndTime = FMath::Max(Entry->EndTime, Now + Duration);
+		return;
+	}
+
+	FAuraDoTEntry& NewEntry = DoTs.AddDefaulted_GetRef();
+	NewEntry.TargetASC = TargetASC;
+	NewEntry.SourceASC = SourceASC;
+	NewEntry.DebuffHandle = DebuffHandle;
+	NewEntry.DamageType = DamageType;
+	NewEntry.Damage = Damage;
+	NewEntry.Period = Period > 0.f ? Period : Duration + 1.f; // no Period means a single tick
+	NewEntry.NextTickTime = Now; // periodic Effects execute on application too
+	NewEntry.EndTime = Now + Duration;
+}
+
+void UAuraDoTSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!bIsServerWorld || DoTs.Num() == 0) return;
+
+	// Damage of this frame, summed per Target, Source and Damage Type
+	struct FPendingDoTDamage
+	{
+		UAbilitySystemComponent* TargetASC;
+		UAbilitySystemComponent* SourceASC;
+		FGameplayTag DamageType;
+		float Damage;
+	};
+	TArray<FPendingDoTDamage, TInlineAllocator<32>> PendingDamages;
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	for (int32 DoTIndex = DoTs.Num() - 1; DoTIndex >= 0; DoTIndex--) {
+		FAuraDoTEntry& DoT = DoTs[DoTIndex];
+
+		// DoT ends with its Debuff Gameplay Effect (expired, removed or Target gone)
+		UAbilitySystemComponent* TargetASC = DoT.TargetASC.Get();
+		if (TargetASC == nullptr || (DoT.DebuffHandle.IsValid() && TargetASC->GetActiveGameplayEffect(DoT.DebuffHandle) == nullptr)) {
+			DoTs.RemoveAtSwap(DoTIndex, 1, false);
+			continue;
+		}
+
+		// Catch up on every tick that is due, in case of a hitch
+		float TickDamage = 0.f;
+		while (DoT.NextTickTime <= Now && DoT.NextTickTime <= DoT.EndTime) {
+			TickDamage += DoT.Damage;
+			DoT.NextTickTime += DoT.Period;
+		}
+
+		if (TickDamage > 0.f) {
+			UAbilitySystemComponent* SourceASC = DoT.SourceASC.Get();
+			FPendingDoTDamage* Pending = PendingDamages.FindByPredicate([&](const FPendingDoTDamage& Other) {
+				return Other.TargetASC == TargetASC && Other.SourceASC == SourceASC && Other.DamageType == DoT.DamageType;
+			});
+			if (Pending) {
+				Pending->Damage += TickDamage;
+			}
+			else {
+				PendingDamages.Add({ TargetASC, SourceASC, DoT.DamageType, TickDamage });
+			}
+		}
+
+		if (DoT.NextTickTime > DoT.EndTime) { // last tick done
+			DoTs.RemoveAtSwap(DoTIndex, 1, false);
+		}
+	}
+
+	for (const FPendingDoTDamage& Pending : PendingDamages) {
+		ApplyDoTDamage(Pending.SourceASC, Pending.TargetASC, Pending.DamageType, Pending.Damage);
+	}
+}
+
+UGameplayEffect* UAuraDoTSubsystem::GetDebuffEffect(const FGameplayTag& DamageType, const FAuraDebuffPolicy& Policy)
+{
+	const FAuraGameplayTags& GameplayTags = FAuraGameplayTags::Get();
+	const EAuraDamageType DamageTypeIndex = GameplayTags.GetDamageTypeIndex(DamageType);
+	if (DamageTypeIndex == EAuraDamageType::Num) return nullptr;
+
+	if (DebuffEffects.Num() == 0) {
+		DebuffEffects.SetNum(static_cast<int32>(EAuraDamageType::Num));
+	}
+
+	TObjectPtr<UGameplayEffect>& Effect = DebuffEffects[static_cast<uint8>(DamageTypeIndex)];
+	if (Effect == nullptr) {
+		// Create Debuff Effect
+		Effect = NewObject<UGameplayEffect>(this, FName(FString::Printf(TEXT("Debuff_%s"), *DamageType.ToString())));
+
+		// Apply Effect Props. The Effect only grants the Debuff Tags, its Damage is ticked by AddDoT
+		Effect->DurationPolicy = EGameplayEffectDurationType::HasDuration; // Duration based
+		FSetByCallerFloat SetByCallerDuration;
+		SetByCallerDuration.DataTag = GameplayTags.Debuff_Info_Duration;
+		Effect->DurationMagnitude = FGameplayEffectModifierMagnitude(SetByCallerDuration);
+
+		// Grant Debuff Tag so Actors know when they are debuffed or not
+		const FGameplayTag DebuffTag = GameplayTags.DamageTypeDebuffTags[static_cast<uint8>(DamageTypeIndex)];
+		Effect->InheritableOwnedTagsContainer.AddTag(DebuffTag);
+
+		// Grant Input Block Tags to Block Input when Actor is Stunned
+		if (DebuffTag.MatchesTagExact(GameplayTags.Debuff_Stun)) {
+			Effect->InheritableOwnedTagsContainer.AddTag(GameplayTags.Player_Block_CursorTrace);
+			Effect->InheritableOwnedTagsContainer.AddTag(GameplayTags.Player_Block_InputPressed);
+			Effect->InheritableOwnedTagsContainer.AddTag(GameplayTags.Player_Block_InputHeld);
+			Effect->InheritableOwnedTagsContainer.AddTag(GameplayTags.Player_Block_InputReleased);
+		}
+
+		// One active Effect per Target whoever applies it, so repeated hits never pile up Effects and Tag stacks
+		Effect->StackingType = EGameplayEffectStackingType::AggregateByTarget;
+		Effect->StackLimitCount = Policy.StackingPolicy == EDebuffStackingPolicy::StackMagnitude ? FMath::Max(Policy.MaxStacks, 1) : 1;
+		Effect->StackDurationRefreshPolicy = Policy.StackingPolicy == EDebuffStackingPolicy::IgnoreWhileActive
+			? EGameplayEffectStackingDurationPolicy::NeverRefresh
+			: EGameplayEffectStackingDurationPolicy::RefreshOnSuccessfulApplication;
+		Effect->StackExpirationPolicy = EGameplayEffectStackingExpirationPolicy::ClearEntireStack;
+	}
+
+	return Effect;
+}
+
+#if !UE_BUILD_SHIPPING
+void UAuraDoTSubsystem::LogDebuffStats() const
+{
+	const FAuraGameplayTags& GameplayTags = FAuraGameplayTags::Get();
+	const FGameplayEffectQuery DebuffQuery = FGameplayEffectQuery::MakeQuery_MatchAnyOwningTags(
+		FGameplayTagContainer::CreateFromArray(GameplayTags.DamageTypeDebuffTags)
+	);
+
+	int32 NumTargets = 0;
+	int32 NumEffects = 0;
+	int32 MaxEffectsPerTarget = 0;
+	for (TObjectIterator<UAbilitySystemComponent> It; It; ++It) {
+		const UAbilitySystemComponent* ASC = *It;
+		if (ASC->GetWorld() != GetWorld()) continue;
+
+		const TArray<FActiveGameplayEffectHandle> DebuffHandles = ASC->GetActiveEffects(DebuffQuery);
+		if (DebuffHandles.Num() == 0) continue;
+
+		int32 NumStacks = 0;
+		for (const FActiveGameplayEffectHandle& Handle : DebuffHandles) {
+			NumStacks += ASC->GetCurrentStackCount(Handle);
+		}
+		UE_LOG(LogAura, Display, TEXT("  %-32s %d Debuff Effects, %d stacks"), *GetNameSafe(ASC->GetAvatarActor()), DebuffHandles.Num(), NumStacks);
+
+		NumTargets++;
+		NumEffects += DebuffHandles.Num();
+		MaxEffectsPerTarget = FMath::Max(MaxEffectsPerTarget, DebuffHandles.Num());
+	}
+
+	UE_LOG(LogAura, Display, TEXT("Debuffs: %d Targets, %d Effects (%.2f per Target, max %d), %d DoTs"),
+		NumTargets, NumEffects, NumTargets > 0 ? static_cast<float>(NumEffects) / NumTargets : 0.f, MaxEffectsPerTarget, DoTs.Num());
+}
+#endif
+
+void UAuraDoTSubsystem::ApplyDoTDamage(UAbilitySystemComponent* SourceASC, UAbilitySystemComponent* TargetASC, const FGameplayTag& DamageType, float Damage)
+{
+	const FAuraGameplayTags& GameplayTags = FAuraGameplayTags::Get();
+
+	if (DoTDamageEffect == nullptr) {
+		// Instant Effect adding the Set By Caller Debuff Damage to IncomingDamage
+		DoTDamageEffect = NewObject<UGameplayEffect>(this, FName("DoTDamage"));
+		DoTDamageEffect->DurationPolicy = EGameplayEffectDurationType::Instant;
+
+		FGameplayModifierInfo& ModifierInfo = DoTDamageEffect->Modifiers.AddDefaulted_GetRef();
+		FSetByCallerFloat SetByCallerDamage;
+		SetByCallerDamage.DataTag = GameplayTags.Debuff_Info_Damage;
+		ModifierInfo.ModifierMagnitude = FGameplayEffectModifierMagnitude(SetByCallerDamage);
+		ModifierInfo.ModifierOp = EGameplayModOp::Additive;
+		ModifierInfo.Attribute = UAuraAttributeSet::GetIncomingDamageAttribute();
+	}
+
+	// If the Source is gone, the Target instigates the Damage itself
+	UAbilitySystemComponent* InstigatorASC = SourceASC ? SourceASC : TargetASC;
+	FGameplayEffectContextHandle EffectContext = InstigatorASC->MakeEffectContext();
+	EffectContext.AddSourceObject(InstigatorASC->GetAvatarActor());
+	UAuraAbilitySystemLibrary::SetDamageType(EffectContext, DamageType);
+
+	FGameplayEffectSpec Spec(DoTDamageEffect, EffectContext, 1.f);
+	Spec.SetSetByCallerMagnitude(GameplayTags.Debuff_Info_Damage, Damage);
+	TargetASC->ApplyGameplayEffectSpecToSelf(Spec);
+}
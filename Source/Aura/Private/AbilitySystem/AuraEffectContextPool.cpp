@@ -0,0 +1,132 @@
+// Copyright Milán Amrein
+
+
+#include "AbilitySystem/AuraEffectContextPool.h"
+#include "Aura/AuraLogChannels.h"
+#include "HAL/IConsoleManager.h"
+
+#if !UE_BUILD_SHIPPING
+/**
+ * Console commands of the Effect Context pool
+ */
+struct FAuraEffectContextPoolCommands
+{
+	static void Stats()
+	{
+		FAuraEffectContextPool::Get().LogStats();
+	}
+
+	static void Benchmark(const TArray<FString>& Args)
+	{
+		// Args: [NumContexts]
+		const int32 NumContexts = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000000;
+		FAuraEffectContextPool::RunBenchmark(FMath::Max(NumContexts, 1));
+	}
+};
+
+static FAutoConsoleCommand CmdAuraEffectContextPoolStats(
+	TEXT("Aura.EffectContextPool.Stats"),
+	TEXT("Logs the number of live, peak and allocated Gameplay Effect Contexts."),
+	FConsoleCommandDelegate::CreateStatic(&FAuraEffectContextPoolCommands::Stats)
+);
+
+static FAutoConsoleCommand CmdAuraEffectContextPoolBenchmark(
+	TEXT("Aura.EffectContextPool.Benchmark"),
+	TEXT("Allocates and frees Gameplay Effect Contexts through the pool and through plain FMemory. Usage: Aura.EffectContextPool.Benchmark [NumContexts]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&FAuraEffectContextPoolCommands::Benchmark)
+);
+#endif
+
+FAuraEffectContextPool& FAuraEffectContextPool::Get()
+{
+	// Never destroyed: contexts held by static objects can still be freed during shutdown
+	static FAuraEffectContextPool* EffectContextPool = new FAuraEffectContextPool();
+
+	return *EffectContextPool;
+}
+
+FAuraEffectContextPool::FAuraEffectContextPool()
+#if AURA_EFFECT_CONTEXT_POOL_STATS
+	: NumLive(0)
+	, PeakLive(0)
+	, NumAllocations(0)
+#endif
+{
+}
+
+void* FAuraEffectContextPool::Allocate()
+{
+	void* Block = Allocator.Allocate();
+
+#if AURA_EFFECT_CONTEXT_POOL_STATS
+	NumAllocations.fetch_add(1, std::memory_order_relaxed);
+	const int64 Live = NumLive.fetch_add(1, std::memory_order_relaxed) + 1;
+	int64 Peak = PeakLive.load(std::memory_order_relaxed);
+	while (Live > Peak && !PeakLive.compare_exchange_weak(Peak, Live, std::memory_order_relaxed)) {}
+#endif
+
+	return Block;
+}
+
+void FAuraEffectContextPool::Free(void* Block)
+{
+	if (Block == nullptr) return;
+
+	Allocator.Free(Block);
+#if AURA_EFFECT_CONTEXT_POOL_STATS
+	NumLive.fetch_sub(1, std::memory_order_relaxed);
+#endif
+}
+
+#if !UE_BUILD_SHIPPING
+void FAuraEffectContextPool::LogStats() const
+{
+#if AURA_EFFECT_CONTEXT_POOL_STATS
+	UE_LOG(LogAura, Display, TEXT("Effect Context pool: %lld live, %lld peak, %lld allocated, %d bytes per context, thread cache %s"),
+		GetNumLive(), GetPeakLive(), GetNumAllocations(), BlockSize, AURA_EFFECT_CONTEXT_POOL_TLS_CACHE ? TEXT("on") : TEXT("off"));
+#else
+	UE_LOG(LogAura, Display, TEXT("Effect Context pool: counters disabled (AURA_EFFECT_CONTEXT_POOL_STATS), %d bytes per context, thread cache %s"),
+		BlockSize, AURA_EFFECT_CONTEXT_POOL_TLS_CACHE ? TEXT("on") : TEXT("off"));
+#endif
+}
+
+void FAuraEffectContextPool::RunBenchmark(int32 NumContexts)
+{
+	// Keep a batch alive at a time, like the contexts of an AoE hitting many Targets
+	constexpr int32 BatchSize = 1024;
+	TArray<FAuraGameplayEffectContext*> Batch;
+	Batch.Reserve(BatchSize);
+
+	const double PoolStartTime = FPlatformTime::Seconds();
+	for (int32 Allocated = 0; Allocated < NumContexts; Allocated += BatchSize) {
+		const int32 NumInBatch = FMath::Min(BatchSize, NumContexts - Allocated);
+		for (int32 Index = 0; Index < NumInBatch; Index++) {
+			Batch.Add(new FAuraGameplayEffectContext());
+		}
+		for (FAuraGameplayEffectContext* Context : Batch) {
+			delete Context;
+		}
+		Batch.Reset();
+	}
+	const double PoolSeconds = FPlatformTime::Seconds() - PoolStartTime;
+
+	const double MallocStartTime = FPlatformTime::Seconds();
+	for (int32 Allocated = 0; Allocated < NumContexts; Allocated += BatchSize) {
+		const int32 NumInBatch = FMath::Min(BatchSize, NumContexts - Allocated);
+		for (int32 Index = 0; Index < NumInBatch; Index++) {
+			Batch.Add(::new (FMemory::Malloc(sizeof(FAuraGameplayEffectContext))) FAuraGameplayEffectContext());
+		}
+		for (FAuraGameplayEffectContext* Context : Batch) {
+			Context->~FAuraGameplayEffectContext();
+			FMemory::Free(Context);
+		}
+		Batch.Reset();
+	}
+	const double MallocSeconds = FPlatformTime::Seconds() - MallocStartTime;
+
+	UE_LOG(LogAura, Display, TEXT("Effect Context benchmark, %d contexts: pool %.2f ms (%.1f ns each), FMemory %.2f ms (%.1f ns each)"),
+		NumContexts,
+		PoolSeconds * 1000.0, PoolSeconds * 1.0e9 / NumContexts,
+		MallocSeconds * 1000.0, MallocSeconds * 1.0e9 / NumContexts);
+}
+#endif
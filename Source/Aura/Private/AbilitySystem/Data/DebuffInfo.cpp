@@ -0,0 +1,17 @@
+// Copyright Milán Amrein
+
+
+#include "AbilitySystem/Data/DebuffInfo.h"
+
+FAuraDebuffPolicy UDebuffInfo::FindDebuffPolicyForTag(const FGameplayTag& DebuffTag) const
+{
+	for (const FAuraDebuffPolicy& Policy : DebuffPolicies) {
+		if (Policy.DebuffTag.MatchesTagExact(DebuffTag)) {
+			return Policy;
+		}
+	}
+
+	FAuraDebuffPolicy DefaultPolicy;
+	DefaultPolicy.DebuffTag = DebuffTag;
+	return DefaultPolicy;
+}
@@ -0,0 +1,298 @@
+// Copyright Milán Amrein
+
+
+#include "AbilitySystem/ExecCalc/AuraDamageMath.h"
+#include "Math/VectorRegister.h"
+#include "Aura/AuraLogChannels.h"
+#include "HAL/IConsoleManager.h"
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommand CmdAuraDamageBatchExactness(
+	TEXT("Aura.Damage.BatchExactness"),
+	TEXT("Feeds the same randomized Damage inputs and seeds to CalculateDamageBatch and to one CalculateDamage call per Target, and compares the results bit by bit. Target counts include non multiples of 4 to cover the scalar tail. Usage: Aura.Damage.BatchExactness [Iterations] [Seed]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args) {
+		const int32 Iterations = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100;
+		FRandomStream InputStream(Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 1);
+
+		// Ranges go past the clamps of the formula, and some Damage Types are 0 or negative to skip them
+		auto RandomInputs = [&InputStream]() {
+			FAuraDamageInputs Inputs;
+			for (int32 TypeIndex = 0; TypeIndex < static_cast<int32>(EAuraDamageType::Num); TypeIndex++) {
+				Inputs.DamageByType[TypeIndex] = InputStream.FRand() < .25f ? 0.f : InputStream.FRandRange(-5.f, 200.f);
+				Inputs.ResistanceByType[TypeIndex] = InputStream.FRandRange(-20.f, 120.f);
+			}
+			Inputs.RadialDamageFalloff = InputStream.FRand() < .5f ? 1.f : InputStream.FRand();
+			Inputs.TargetBlockChance = InputStream.FRandRange(-10.f, 60.f);
+			Inputs.TargetArmor = InputStream.FRandRange(-10.f, 200.f);
+			Inputs.SourceArmorPenetration = InputStream.FRandRange(-10.f, 400.f);
+			Inputs.SourceCriticalHitChance = InputStream.FRandRange(-10.f, 80.f);
+			Inputs.TargetCriticalHitResistance = InputStream.FRandRange(-10.f, 100.f);
+			Inputs.SourceCriticalHitDamage = InputStream.FRandRange(-10.f, 100.f);
+			Inputs.ArmorPenetrationCoefficient = InputStream.FRand();
+			Inputs.EffectiveArmorCoefficient = InputStream.FRand();
+			Inputs.CriticalHitResistanceCoefficient = InputStream.FRand();
+			return Inputs;
+		};
+		auto FloatBits = [](float Value) {
+			uint32 Bits = 0;
+			FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+			return Bits;
+		};
+
+		const int32 TargetCounts[] = { 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 128, 129, 1001 };
+		int64 NumCompared = 0;
+		int32 NumMismatches = 0;
+		for (int32 Iteration = 0; Iteration < Iterations; Iteration++) {
+			for (const int32 NumTargets : TargetCounts) {
+				FAuraDamageBatch Batch;
+				Batch.SetNum(NumTargets);
+				for (int32 TargetIndex = 0; TargetIndex < NumTargets; TargetIndex++) {
+					Batch.SetTarget(TargetIndex, RandomInputs());
+				}
+
+				// Both paths start every Target from the same seed and must leave its Stream in the same state
+				TArray<FRandomStream> BatchStreams;
+				for (int32 TargetIndex = 0; TargetIndex < NumTargets; TargetIndex++) {
+					BatchStreams.Emplace(static_cast<int32>(InputStream.GetUnsignedInt()));
+				}
+				TArray<FRandomStream> ScalarStreams = BatchStreams;
+				TArray<FAuraDamageResult> BatchResults;
+				BatchResults.SetNum(NumTargets);
+				FAuraDamageMath::CalculateDamageBatch(Batch, BatchStreams, BatchResults);
+
+				for (int32 TargetIndex = 0; TargetIndex < NumTargets; TargetIndex++) {
+					const FAuraDamageResult ScalarResult = FAuraDamageMath::CalculateDamage(Batch.GetTarget(TargetIndex), ScalarStreams[TargetIndex]);
+					const FAuraDamageResult& BatchResult = BatchResults[TargetIndex];
+					NumCompared++;
+					if (FloatBits(ScalarResult.Damage) != FloatBits(BatchResult.Damage) || ScalarResult.bBlockedHit != BatchResult.bBlockedHit || ScalarResult.bCriticalHit != BatchResult.bCriticalHit) {
+						if (NumMismatches++ < 10) {
+							UE_LOG(LogAura, Warning, TEXT("Target %d of %d: scalar 0x%08x (%.9g) Block %d Crit %d, batch 0x%08x (%.9g) Block %d Crit %d"),
+								TargetIndex, NumTargets,
+								FloatBits(ScalarResult.Damage), ScalarResult.Damage, ScalarResult.bBlockedHit, ScalarResult.bCriticalHit,
+								FloatBits(BatchResult.Damage), BatchResult.Damage, BatchResult.bBlockedHit, BatchResult.bCriticalHit);
+						}
+					}
+					if (BatchStreams[TargetIndex].GetCurrentSeed() != ScalarStreams[TargetIndex].GetCurrentSeed()) {
+						NumMismatches++;
+						UE_LOG(LogAura, Warning, TEXT("Target %d of %d: batch and scalar consumed the Random Stream differently"), TargetIndex, NumTargets);
+					}
+				}
+			}
+		}
+
+		UE_LOG(LogAura, Log, TEXT("Damage batch exactness: %lld Targets compared, %d mismatches: %s"),
+			NumCompared, NumMismatches, NumMismatches == 0 ? TEXT("PASSED") : TEXT("FAILED"));
+	})
+);
+#endif
+
+void FAuraDamageBatch::SetNum(int32 NumTargets)
+{
+	for (int32 TypeIndex = 0; TypeIndex < static_cast<int32>(EAuraDamageType::Num); TypeIndex++) {
+		DamageByType[TypeIndex].SetNumZeroed(NumTargets);
+		ResistanceByType[TypeIndex].SetNumZeroed(NumTargets);
+	}
+	RadialDamageFalloff.SetNumZeroed(NumTargets);
+	TargetBlockChance.SetNumZeroed(NumTargets);
+	TargetArmor.SetNumZeroed(NumTargets);
+	SourceArmorPenetration.SetNumZeroed(NumTargets);
+	SourceCriticalHitChance.SetNumZeroed(NumTargets);
+	TargetCriticalHitResistance.SetNumZeroed(NumTargets);
+	SourceCriticalHitDamage.SetNumZeroed(NumTargets);
+	ArmorPenetrationCoefficient.SetNumZeroed(NumTargets);
+	EffectiveArmorCoefficient.SetNumZeroed(NumTargets);
+	CriticalHitResistanceCoefficient.SetNumZeroed(NumTargets);
+}
+
+void FAuraDamageBatch::SetTarget(int32 TargetIndex, const FAuraDamageInputs& Inputs)
+{
+	for (int32 TypeIndex = 0; TypeIndex < static_cast<int32>(EAuraDamageType::Num); TypeIndex++) {
+		DamageByType[TypeIndex][TargetIndex] = Inputs.DamageByType[TypeIndex];
+		ResistanceByType[TypeIndex][TargetIndex] = Inputs.ResistanceByType[TypeIndex];
+	}
+	RadialDamageFalloff[TargetIndex] = Inputs.RadialDamageFalloff;
+	TargetBlockChance[TargetIndex] = Inputs.TargetBlockChance;
+	TargetArmor[TargetIndex] = Inputs.TargetArmor;
+	SourceArmorPenetration[TargetIndex] = Inputs.SourceArmorPenetration;
+	SourceCriticalHitChance[TargetIndex] = Inputs.SourceCriticalHitChance;
+	TargetCriticalHitResistance[TargetIndex] = Inputs.TargetCriticalHitResistance;
+	SourceCriticalHitDamage[TargetIndex] = Inputs.SourceCriticalHitDamage;
+	ArmorPenetrationCoefficient[TargetIndex] = Inputs.ArmorPenetrationCoefficient;
+	EffectiveArmorCoefficient[TargetIndex] = Inputs.EffectiveArmorCoefficient;
+	CriticalHitResistanceCoefficient[TargetIndex] = Inputs.CriticalHitResistanceCoefficient;
+}
+
+FAuraDamageInputs FAuraDamageBatch::GetTarget(int32 TargetIndex) const
+{
+	FAuraDamageInputs Inputs;
+	for (int32 TypeIndex = 0; TypeIndex < static_cast<int32>(EAuraDamageType::Num); TypeIndex++) {
+		Inputs.DamageByType[TypeIndex] = DamageByType[TypeIndex][TargetIndex];
+		Inputs.ResistanceByType[TypeIndex] = ResistanceByType[TypeIndex][TargetIndex];
+	}
+	Inputs.RadialDamageFalloff = RadialDamageFalloff[TargetIndex];
+	Inputs.TargetBlockChance = TargetBlockChance[TargetIndex];
+	Inputs.TargetArmor = TargetArmor[TargetIndex];
+	Inputs.SourceArmorPenetration = SourceArmorPenetration[TargetIndex];
+	Inputs.SourceCriticalHitChance = SourceCriticalHitChance[TargetIndex];
+	Inputs.TargetCriticalHitResistance = TargetCriticalHitResistance[TargetIndex];
+	Inputs.SourceCriticalHitDamage = SourceCriticalHitDamage[TargetIndex];
+	Inputs.ArmorPenetrationCoefficient = ArmorPenetrationCoefficient[TargetIndex];
+	Inputs.EffectiveArmorCoefficient = EffectiveArmorCoefficient[TargetIndex];
+	Inputs.CriticalHitResistanceCoefficient = CriticalHitResistanceCoefficient[TargetIndex];
+	return Inputs;
+}
+
+FAuraDamageResult FAuraDamageMath::CalculateDamage(const FAuraDamageInputs& Inputs, FRandomStream& CombatStream)
+{
+	// Block is rolled before Critical Hit
+	const float BlockRoll = static_cast<float>(CombatStream.RandRange(1, 100));
+	const float CriticalHitRoll = static_cast<float>(CombatStream.RandRange(1, 100));
+
+	return CalculateDamageFromRolls(Inputs, BlockRoll, CriticalHitRoll);
+}
+
+FAuraDamageResult FAuraDamageMath::CalculateDamageFromRolls(const FAuraDamageInputs& Inputs, float BlockRoll, float CriticalHitRoll)
+{
+	FAuraDamageResult Result;
+	float Damage = CalculateResistedDamage(Inputs);
+
+	// Determine if there was a successful Block. If Block, halve the damage.
+	// BlockChance is a chance, so e.g. if it is 25%, then block will be successful if the random number is less than 26
+	Result.bBlockedHit = BlockRoll < FMath::Max<float>(0.f, Inputs.TargetBlockChance);
+	Damage = Result.bBlockedHit ? Damage / 2.f : Damage;
+
+	Damage = ApplyArmor(Damage, Inputs);
+
+	// If CriticalHitChance results in a Critical Hit, double Damage plus a bonus
+	Result.bCriticalHit = CriticalHitRoll < GetEffectiveCriticalHitChance(Inputs);
+	Damage = Result.bCriticalHit ? 2.f * Damage + FMath::Max<float>(0.f, Inputs.SourceCriticalHitDamage) : Damage;
+
+	Result.Damage = Damage;
+	return Result;
+}
+
+float FAuraDamageMath::CalculateResistedDamage(const FAuraDamageInputs& Inputs)
+{
+	float Damage = 0.f;
+	for (int32 TypeIndex = 0; TypeIndex < static_cast<int32>(EAuraDamageType::Num); TypeIndex++) {
+		float DamageTypeValue = Inputs.DamageByType[TypeIndex];
+		if (DamageTypeValue <= 0.f) { // if there is no Damage Value, continue iteration
+			continue;
+		}
+
+		const float Resistance = FMath::Clamp(Inputs.ResistanceByType[TypeIndex], 0.f, 100.f); // should be between 0 and 100
+		DamageTypeValue *= (100.f - Resistance) / 100.f; // if Resistance is e.g. 90%, then reduce Damage by 90%
+
+		// Scale the Damage by the distance from the Radial Damage Origin (1 if not Radial)
+		DamageTypeValue *= Inputs.RadialDamageFalloff;
+
+		Damage += DamageTypeValue;
+	}
+
+	return Damage;
+}
+
+float FAuraDamageMath::ApplyArmor(float Damage, const FAuraDamageInputs& Inputs)
+{
+	const float TargetArmor = FMath::Max<float>(0.f, Inputs.TargetArmor);
+	const float SourceArmorPenetration = FMath::Max<float>(0.f, Inputs.SourceArmorPenetration);
+
+	// Armor Penetration ignores a percentage of Target's Armor
+	// If e.g. SourceArmorPenetration is 400 and coefficient is .25f, then EffectiveArmor is 0, meaning the Attacker can ignore all of Target's Armor.
+	const float EffectiveArmor = TargetArmor * (100 - SourceArmorPenetration * Inputs.ArmorPenetrationCoefficient) / 100.f;
+
+	// It would take EffectiveArmorCoefficient points of EffectiveArmor to ignore 1% of the Damage
+	return Damage * (100 - EffectiveArmor * Inputs.EffectiveArmorCoefficient) / 100.f;
+}
+
+float FAuraDamageMath::GetEffectiveCriticalHitChance(const FAuraDamageInputs& Inputs)
+{
+	const float SourceCriticalHitChance = FMath::Max<float>(0.f, Inputs.SourceCriticalHitChance);
+	const float TargetCriticalHitResistance = FMath::Max<float>(0.f, Inputs.TargetCriticalHitResistance);
+
+	// CriticalHitResistance reduces CriticalHitChance by a certain percentage, which is a chance like BlockChance
+	return SourceCriticalHitChance - TargetCriticalHitResistance * Inputs.CriticalHitResistanceCoefficient;
+}
+
+bool FAuraDamageMath::RollChance(FRandomStream& CombatStream, float Chance)
+{
+	return CombatStream.RandRange(1, 100) < Chance;
+}
+
+void FAuraDamageMath::CalculateDamageBatch(const FAuraDamageBatch& Batch, TArrayView<FRandomStream> CombatStreams, TArrayView<FAuraDamageResult> OutResults)
+{
+	const int32 NumTargets = Batch.Num();
+	check(OutResults.Num() == NumTargets && CombatStreams.Num() == NumTargets);
+
+	// Roll up front in the same order as the scalar path (Block then Critical Hit), so each Target's Stream is consumed identically
+	TArray<float, TInlineAllocator<64>> BlockRolls;
+	TArray<float, TInlineAllocator<64>> CriticalHitRolls;
+	BlockRolls.SetNumUninitialized(NumTargets);
+	CriticalHitRolls.SetNumUninitialized(NumTargets);
+	for (int32 TargetIndex = 0; TargetIndex < NumTargets; TargetIndex++) {
+		BlockRolls[TargetIndex] = static_cast<float>(CombatStreams[TargetIndex].RandRange(1, 100));
+		CriticalHitRolls[TargetIndex] = static_cast<float>(CombatStreams[TargetIndex].RandRange(1, 100));
+	}
+
+	// Same operations in the same order as CalculateDamage, four Targets at a time
+	const VectorRegister4Float Zero = VectorZeroFloat();
+	const VectorRegister4Float Two = VectorSetFloat1(2.f);
+	const VectorRegister4Float Hundred = VectorSetFloat1(100.f);
+
+	int32 TargetIndex = 0;
+	for (; TargetIndex + 4 <= NumTargets; TargetIndex += 4) {
+		// Resistances & Radial Damage falloff
+		const VectorRegister4Float Falloff = VectorLoad(&Batch.RadialDamageFalloff[TargetIndex]);
+		VectorRegister4Float Damage = Zero;
+		for (int32 TypeIndex = 0; TypeIndex < static_cast<int32>(EAuraDamageType::Num); TypeIndex++) {
+			const VectorRegister4Float DamageTypeValue = VectorLoad(&Batch.DamageByType[TypeIndex][TargetIndex]);
+			const VectorRegister4Float Resistance = VectorMin(VectorMax(VectorLoad(&Batch.ResistanceByType[TypeIndex][TargetIndex]), Zero), Hundred);
+			VectorRegister4Float Resisted = VectorMultiply(DamageTypeValue, VectorDivide(VectorSubtract(Hundred, Resistance), Hundred));
+			Resisted = VectorMultiply(Resisted, Falloff);
+			Damage = VectorAdd(Damage, VectorSelect(VectorCompareGT(DamageTypeValue, Zero), Resisted, Zero));
+		}
+
+		// Block
+		const VectorRegister4Float BlockChance = VectorMax(Zero, VectorLoad(&Batch.TargetBlockChance[TargetIndex]));
+		const VectorRegister4Float BlockedMask = VectorCompareGT(BlockChance, VectorLoad(&BlockRolls[TargetIndex]));
+		Damage = VectorSelect(BlockedMask, VectorDivide(Damage, Two), Damage);
+
+		// Armor Penetration & Effective Armor
+		const VectorRegister4Float TargetArmor = VectorMax(Zero, VectorLoad(&Batch.TargetArmor[TargetIndex]));
+		const VectorRegister4Float SourceArmorPenetration = VectorMax(Zero, VectorLoad(&Batch.SourceArmorPenetration[TargetIndex]));
+		const VectorRegister4Float EffectiveArmor = VectorDivide(
+			VectorMultiply(TargetArmor, VectorSubtract(Hundred, VectorMultiply(SourceArmorPenetration, VectorLoad(&Batch.ArmorPenetrationCoefficient[TargetIndex])))),
+			Hundred
+		);
+		Damage = VectorDivide(
+			VectorMultiply(Damage, VectorSubtract(Hundred, VectorMultiply(EffectiveArmor, VectorLoad(&Batch.EffectiveArmorCoefficient[TargetIndex])))),
+			Hundred
+		);
+
+		// Critical Hit
+		const VectorRegister4Float EffectiveCriticalHitChance = VectorSubtract(
+			VectorMax(Zero, VectorLoad(&Batch.SourceCriticalHitChance[TargetIndex])),
+			VectorMultiply(VectorMax(Zero, VectorLoad(&Batch.TargetCriticalHitResistance[TargetIndex])), VectorLoad(&Batch.CriticalHitResistanceCoefficient[TargetIndex]))
+		);
+		const VectorRegister4Float CriticalMask = VectorCompareGT(EffectiveCriticalHitChance, VectorLoad(&CriticalHitRolls[TargetIndex]));
+		const VectorRegister4Float CriticalDamage = VectorAdd(VectorMultiply(Two, Damage), VectorMax(Zero, VectorLoad(&Batch.SourceCriticalHitDamage[TargetIndex])));
+		Damage = VectorSelect(CriticalMask, CriticalDamage, Damage);
+
+		// Write back
+		float DamageLanes[4];
+		VectorStore(Damage, DamageLanes);
+		const int32 BlockedBits = VectorMaskBits(BlockedMask);
+		const int32 CriticalBits = VectorMaskBits(CriticalMask);
+		for (int32 Lane = 0; Lane < 4; Lane++) {
+			FAuraDamageResult& Result = OutResults[TargetIndex + Lane];
+			Result.Damage = DamageLanes[Lane];
+			Result.bBlockedHit = (BlockedBits & (1 << Lane)) != 0;
+			Result.bCriticalHit = (CriticalBits & (1 << Lane)) != 0;
+		}
+	}
+
+	// Remaining Targets go through the scalar path with the already rolled values
+	for (; TargetIndex < NumTargets; TargetIndex++) {
+		OutResults[TargetIndex] = CalculateDamageFromRolls(Batch.GetTarget(TargetIndex), BlockRolls[TargetIndex], CriticalHitRolls[TargetIndex]);
+	}
+}
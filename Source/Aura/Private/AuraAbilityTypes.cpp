@@ -1,9 +1,55 @@
 
 #include "AuraAbilityTypes.h"
+#include "AbilitySystem/AuraEffectContextPool.h"
+#include "Aura/AuraLogChannels.h"
+#include "Engine/NetSerialization.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/CoreNet.h"
+
+void FAuraDamageTypeMap::Add(const FGameplayTag& DamageTypeTag, float Damage)
+{
+	const EAuraDamageType DamageType = FAuraGameplayTags::Get().GetDamageTypeIndex(DamageTypeTag);
+	if (!ensureMsgf(DamageType != EAuraDamageType::Num, TEXT("[%s] is not a Damage Type, its Damage of %f is dropped"), *DamageTypeTag.ToString(), Damage)) return;
+
+	Damages[static_cast<uint8>(DamageType)] = Damage;
+	SetMask |= 1 << static_cast<uint8>(DamageType);
+}
+
+float FAuraDamageTypeMap::Find(const FGameplayTag& DamageTypeTag) const
+{
+	const EAuraDamageType DamageType = FAuraGameplayTags::Get().GetDamageTypeIndex(DamageTypeTag);
+
+	return DamageType != EAuraDamageType::Num ? Get(DamageType) : 0.f;
+}
+
+void* FAuraGameplayEffectContext::operator new(size_t Size)
+{
+	// Derived contexts do not fit into a block
+	return Size <= FAuraEffectContextPool::BlockSize ? FAuraEffectContextPool::Get().Allocate() : FMemory::Malloc(Size);
+}
+
+void FAuraGameplayEffectContext::operator delete(void* Block, size_t Size)
+{
+	if (Size <= FAuraEffectContextPool::BlockSize) {
+		FAuraEffectContextPool::Get().Free(Block);
+	}
+	else {
+		FMemory::Free(Block);
+	}
+}
 
 bool FAuraGameplayEffectContext::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
 {
-	// Save struct members as bits for NetSerialize
+	// Version of the wire format, so a stale format (e.g. in a replay) fails loudly instead of misreading bits
+	uint8 Version = NetSerializeVersion;
+	Ar.SerializeBits(&Version, NetSerializeVersionBits);
+	if (Ar.IsLoading() && Version != NetSerializeVersion) {
+		UE_LOG(LogAura, Error, TEXT("FAuraGameplayEffectContext: unsupported NetSerialize version [%d], expected [%d]"), Version, NetSerializeVersion);
+		bOutSuccess = false;
+		return false;
+	}
+
+	// Save struct members as bits for NetSerialize. Boolean members are sent as their bit only
 	uint32 RepBits = 0; // we need more than 8 bits
 	if (Ar.IsSaving()) {
 		// Flipping bits
@@ -45,129 +91,108 @@ bool FAuraGameplayEffectContext::NetSerialize(FArchive& Ar, UPackageMap* Map, bo
 		if (bIsSuccessfulDebuff) {
 			RepBits |= 1 << 9;
 		}
-		if (DebuffDamage > 0.f) {
+		if (DamageType != EAuraDamageType::Num) {
 			RepBits |= 1 << 10;
 		}
-		if (DebuffDuration > 0.f) {
-			RepBits |= 1 << 11;
-		}
-		if (DebuffFrequency > 0.f) {
-			RepBits |= 1 << 12;
-		}
-		if (DamageType.IsValid()) {
-			RepBits |= 1 << 13;
-		}
 		if (!DeathImpulse.IsZero()) {
-			RepBits |= 1 << 14;
+			RepBits |= 1 << 11;
 		}
 		if (!KnockbackForce.IsZero()) {
-			RepBits |= 1 << 15;
+			RepBits |= 1 << 12;
 		}
 		if (bIsRadialDamage) {
-			RepBits |= 1 << 16;
-
-			if (RadialDamageInnerRadius > 0.f) {
-				RepBits |= 1 << 17;
-			}
-			if (RadialDamageOuterRadius > 0.f) {
-				RepBits |= 1 << 18;
-			}
-			if (!RadialDamageOrigin.IsZero()) {
-				RepBits |= 1 << 19;
-			}
+			RepBits |= 1 << 13;
 		}
+	}
 
-		Ar.SerializeBits(&RepBits, 19); // Serialization
+	Ar.SerializeBits(&RepBits, NetSerializeRepBits); // Serialization
 
-		// Save to Archive
-		if (RepBits & (1 << 0))
-		{
-			Ar << Instigator;
-		}
-		if (RepBits & (1 << 1))
-		{
-			Ar << EffectCauser;
-		}
-		if (RepBits & (1 << 2))
-		{
-			Ar << AbilityCDO;
-		}
-		if (RepBits & (1 << 3))
-		{
-			Ar << SourceObject;
-		}
-		if (RepBits & (1 << 4))
-		{
-			SafeNetSerializeTArray_Default<31>(Ar, Actors);
-		}
-		if (RepBits & (1 << 5))
-		{
-			if (Ar.IsLoading())
-			{
-				if (!HitResult.IsValid())
-				{
-					HitResult = TSharedPtr<FHitResult>(new FHitResult());
-				}
-			}
-			HitResult->NetSerialize(Ar, Map, bOutSuccess);
-		}
-		if (RepBits & (1 << 6))
-		{
-			Ar << WorldOrigin;
-			bHasWorldOrigin = true;
-		}
-		else
-		{
-			bHasWorldOrigin = false;
-		}
-		if (RepBits & (1 << 7)) {
-			Ar << bIsBlockedHit;
-		}
-		if (RepBits & (1 << 8)) {
-			Ar << bIsCriticalHit;
-		}
-		if (RepBits & (1 << 9)) {
-			Ar << bIsSuccessfulDebuff;
-		}
-		if (RepBits & (1 << 10)) {
-			Ar << DebuffDamage;
-		}
-		if (RepBits & (1 << 11)) {
-			Ar << DebuffDuration;
-		}
-		if (RepBits & (1 << 12)) {
-			Ar << DebuffFrequency;
-		}
-		if (RepBits & (1 << 13))
+	// Save to / load from Archive
+	if (RepBits & (1 << 0))
+	{
+		Ar << Instigator;
+	}
+	if (RepBits & (1 << 1))
+	{
+		Ar << EffectCauser;
+	}
+	if (RepBits & (1 << 2))
+	{
+		Ar << AbilityCDO;
+	}
+	if (RepBits & (1 << 3))
+	{
+		Ar << SourceObject;
+	}
+	if (RepBits & (1 << 4))
+	{
+		SafeNetSerializeTArray_Default<31>(Ar, Actors);
+	}
+	if (RepBits & (1 << 5))
+	{
+		if (Ar.IsLoading())
 		{
-			if (Ar.IsLoading())
+			if (!HitResult.IsValid())
 			{
-				if (!DamageType.IsValid())
-				{
-					DamageType = TSharedPtr<FGameplayTag>(new FGameplayTag());
-				}
+				HitResult = TSharedPtr<FHitResult>(new FHitResult());
 			}
-			DamageType->NetSerialize(Ar, Map, bOutSuccess);
-		}
-		if (RepBits & (1 << 14)) {
-			DeathImpulse.NetSerialize(Ar, Map, bOutSuccess);
 		}
-		if (RepBits & (1 << 15)) {
-			KnockbackForce.NetSerialize(Ar, Map, bOutSuccess);
-		}
-		if (RepBits & (1 << 16)) {
-			Ar << bIsRadialDamage;
+		HitResult->NetSerialize(Ar, Map, bOutSuccess);
+	}
+	if (RepBits & (1 << 6))
+	{
+		Ar << WorldOrigin;
+		bHasWorldOrigin = true;
+	}
+	else
+	{
+		bHasWorldOrigin = false;
+	}
 
-			if (RepBits & (1 << 17)) {
-				Ar << RadialDamageInnerRadius;
-			}
-			if (RepBits & (1 << 18)) {
-				Ar << RadialDamageOuterRadius;
-			}
-			if (RepBits & (1 << 19)) {
-				RadialDamageOrigin.NetSerialize(Ar, Map, bOutSuccess);
-			}
-		}
+	bIsBlockedHit = (RepBits & (1 << 7)) != 0;
+	bIsCriticalHit = (RepBits & (1 << 8)) != 0;
+	bIsSuccessfulDebuff = (RepBits & (1 << 9)) != 0;
+	if (bIsSuccessfulDebuff) {
+		// Debuff parameters only mean something for a successful Debuff
+		Ar << DebuffDamage;
+		Ar << DebuffDuration;
+		Ar << DebuffFrequency;
+	}
+	else if (Ar.IsLoading()) {
+		DebuffDamage = 0.f;
+		DebuffDuration = 0.f;
+		DebuffFrequency = 0.f;
+	}
+
+	if (RepBits & (1 << 10)) {
+		// Damage Type is sent as its EAuraDamageType index
+		uint32 DamageTypeIndex = static_cast<uint32>(DamageType);
+		Ar.SerializeInt(DamageTypeIndex, static_cast<uint32>(EAuraDamageType::Num));
+		DamageType = static_cast<EAuraDamageType>(DamageTypeIndex);
+	}
+	else if (Ar.IsLoading()) {
+		DamageType = EAuraDamageType::Num;
+	}
+
+	// Vectors are quantized to one decimal place like FVector_NetQuantize10, out of range components are clamped
+	if (RepBits & (1 << 11)) {
+		SerializePackedVector<10, 24>(DeathImpulse, Ar);
+	}
+	else if (Ar.IsLoading()) {
+		DeathImpulse = FVector::ZeroVector;
+	}
+	if (RepBits & (1 << 12)) {
+		SerializePackedVector<10, 24>(KnockbackForce, Ar);
+	}
+	else if (Ar.IsLoading()) {
+		KnockbackForce = FVector::ZeroVector;
+	}
+
+	bIsRadialDamage = (RepBits & (1 << 13)) != 0;
+	if (bIsRadialDamage) {
+		Ar << RadialDamageInnerRadius;
+		Ar << RadialDamageOuterRadius;
+		SerializePackedVector<10, 24>(RadialDamageOrigin, Ar);
 	}
 
 	if (Ar.IsLoading())
@@ -178,3 +203,101 @@ bool FAuraGameplayEffectContext::NetSerialize(FArchive& Ar, UPackageMap* Map, bo
 	bOutSuccess = true;
 	return true;
 }
+
+#if !UE_BUILD_SHIPPING
+/**
+ * Bandwidth report of FAuraGameplayEffectContext::NetSerialize.
+ * Round trips typical hits through a bit writer and reader and through Duplicate, then logs their size on the wire.
+ * Object references (Instigator, Effect Causer...) need a live Package Map, so they are left out of the report.
+ */
+struct FAuraEffectContextNetReport
+{
+	static void Run()
+	{
+		const FAuraGameplayTags& GameplayTags = FAuraGameplayTags::Get();
+
+		FAuraGameplayEffectContext PlainHit;
+		PlainHit.SetDamageType(GameplayTags.Damage_Fire);
+
+		FAuraGameplayEffectContext CriticalKnockbackHit = PlainHit;
+		CriticalKnockbackHit.SetIsCriticalHit(true);
+		CriticalKnockbackHit.SetKnockbackForce(FVector(412.37f, -96.5f, 250.f));
+
+		FAuraGameplayEffectContext DebuffHit = PlainHit;
+		DebuffHit.SetIsSuccessfulDebuff(true);
+		DebuffHit.SetDebuffDamage(5.f);
+		DebuffHit.SetDebuffDuration(5.f);
+		DebuffHit.SetDebuffFrequency(1.f);
+
+		FAuraGameplayEffectContext RadialHit = PlainHit;
+		RadialHit.SetIsRadialDamage(true);
+		RadialHit.SetRadialDamageInnerRadius(50.f);
+		RadialHit.SetRadialDamageOuterRadius(300.f);
+		RadialHit.SetRadialDamageOrigin(FVector(1520.25f, -830.f, 92.15f));
+
+		FAuraGameplayEffectContext FatalHit = CriticalKnockbackHit;
+		FatalHit.SetDeathImpulse(FVector(-8250.4f, 3300.f, 1500.f));
+
+		bool bAllRoundTripped = true;
+		bAllRoundTripped &= Report(TEXT("Plain hit"), PlainHit);
+		bAllRoundTripped &= Report(TEXT("Critical hit with knockback"), CriticalKnockbackHit);
+		bAllRoundTripped &= Report(TEXT("Debuff hit"), DebuffHit);
+		bAllRoundTripped &= Report(TEXT("Radial hit"), RadialHit);
+		bAllRoundTripped &= Report(TEXT("Fatal hit"), FatalHit);
+
+		UE_LOG(LogAura, Display, TEXT("Effect Context round trip and duplication: %s"), bAllRoundTripped ? TEXT("OK") : TEXT("FAILED"));
+	}
+
+private:
+
+	// Function to serialize, deserialize, duplicate and compare a Context, returns whether or not it survived both
+	static bool Report(const TCHAR* Name, FAuraGameplayEffectContext& Context)
+	{
+		FNetBitWriter Writer(nullptr, 1024 * 8);
+		bool bSuccess = false;
+		Context.NetSerialize(Writer, nullptr, bSuccess);
+
+		FNetBitReader Reader(nullptr, Writer.GetData(), Writer.GetNumBits());
+		FAuraGameplayEffectContext Loaded;
+		Loaded.NetSerialize(Reader, nullptr, bSuccess);
+
+		const bool bRoundTripped = bSuccess && !Reader.IsError() && Reader.GetBitsLeft() == 0 && IsEquivalent(Context, Loaded);
+
+		// GAS duplicates Contexts per Target and for Gameplay Cues, the copy must keep every Aura member
+		const TUniquePtr<FAuraGameplayEffectContext> Duplicated(Context.Duplicate());
+		const bool bDuplicated = Duplicated->GetScriptStruct() == FAuraGameplayEffectContext::StaticStruct() && IsEquivalent(Context, *Duplicated);
+
+		UE_LOG(LogAura, Display, TEXT("%-28s %4lld bits (%3lld bytes) %s%s"),
+			Name, Writer.GetNumBits(), Writer.GetNumBytes(),
+			bRoundTripped ? TEXT("") : TEXT("ROUND TRIP MISMATCH "),
+			bDuplicated ? TEXT("") : TEXT("DUPLICATE MISMATCH"));
+
+		return bRoundTripped && bDuplicated;
+	}
+
+	// Function to compare the custom members of two Contexts, vectors within their quantization step
+	static bool IsEquivalent(const FAuraGameplayEffectContext& A, const FAuraGameplayEffectContext& B)
+	{
+		constexpr float QuantizeTolerance = 0.1f;
+		return A.GetDamageTypeIndex() == B.GetDamageTypeIndex()
+			&& A.IsBlockedHit() == B.IsBlockedHit()
+			&& A.IsCriticalHit() == B.IsCriticalHit()
+			&& A.IsSuccessfulDebuff() == B.IsSuccessfulDebuff()
+			&& A.GetDebuffDamage() == B.GetDebuffDamage()
+			&& A.GetDebuffDuration() == B.GetDebuffDuration()
+			&& A.GetDebuffFrequency() == B.GetDebuffFrequency()
+			&& A.GetDeathImpulse().Equals(B.GetDeathImpulse(), QuantizeTolerance)
+			&& A.GetKnockbackForce().Equals(B.GetKnockbackForce(), QuantizeTolerance)
+			&& A.IsRadialDamage() == B.IsRadialDamage()
+			&& A.GetRadialDamageInnerRadius() == B.GetRadialDamageInnerRadius()
+			&& A.GetRadialDamageOuterRadius() == B.GetRadialDamageOuterRadius()
+			&& A.GetRadialDamageOrigin().Equals(B.GetRadialDamageOrigin(), QuantizeTolerance);
+	}
+};
+
+static FAutoConsoleCommand CmdAuraEffectContextNetReport(
+	TEXT("Aura.Net.EffectContextReport"),
+	TEXT("Round trips typical hits through FAuraGameplayEffectContext::NetSerialize and Duplicate, and logs their size in bits."),
+	FConsoleCommandDelegate::CreateStatic(&FAuraEffectContextNetReport::Run)
+);
+#endif
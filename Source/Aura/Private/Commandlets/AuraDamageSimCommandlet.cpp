@@ -0,0 +1,259 @@
+// Copyright Milán Amrein
+
+
+#include "Commandlets/AuraDamageSimCommandlet.h"
+#include "AbilitySystem/Abilities/AuraDamageGameplayAbility.h"
+#include "AbilitySystem/Data/CharacterClassInfo.h"
+#include "AbilitySystem/ExecCalc/AuraDamageMath.h"
+#include "AuraGameplayTags.h"
+#include "Aura/AuraLogChannels.h"
+#include "AbilitySystem/AuraAttributeSet.h"
+#include "AbilitySystemComponent.h"
+#include "AbilitySystemGlobals.h"
+#include "GameplayEffect.h"
+#include "Engine/CurveTable.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+UAuraDamageSimCommandlet::UAuraDamageSimCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UAuraDamageSimCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamVals;
+	ParseCommandLine(*Params, Tokens, Switches, ParamVals);
+
+	auto GetParam = [&ParamVals](const TCHAR* Key, const FString& Default) {
+		const FString* Value = ParamVals.Find(Key);
+		return Value ? *Value : Default;
+	};
+
+	const FAuraGameplayTags& GameplayTags = FAuraGameplayTags::Get();
+	if (GameplayTags.DamageTypeTags.Num() != static_cast<int32>(EAuraDamageType::Num)) {
+		UE_LOG(LogAura, Error, TEXT("AuraDamageSim: Native Gameplay Tags are not initialized, check the AssetManagerClassName in DefaultEngine.ini"));
+		return 1;
+	}
+
+	// Load Data Assets
+	const FString ClassInfoPath = GetParam(TEXT("ClassInfo"), TEXT("/Game/Blueprint/AbilitySystem/Data/DA_CharacterClassInfo.DA_CharacterClassInfo"));
+	const UCharacterClassInfo* CharacterClassInfo = LoadObject<UCharacterClassInfo>(nullptr, *ClassInfoPath);
+	const UClass* AbilityClass = LoadClass<UAuraDamageGameplayAbility>(nullptr, *GetParam(TEXT("Ability"), FString()));
+	if (CharacterClassInfo == nullptr || AbilityClass == nullptr) {
+		UE_LOG(LogAura, Error, TEXT("AuraDamageSim: Failed to load ClassInfo or Ability. See the usage in AuraDamageSimCommandlet.h"));
+		return 1;
+	}
+	const UAuraDamageGameplayAbility* Ability = AbilityClass->GetDefaultObject<UAuraDamageGameplayAbility>();
+
+	// Character Classes of the Attacker and the Defender
+	const UEnum* CharacterClassEnum = StaticEnum<ECharacterClass>();
+	const int64 AttackerClassValue = CharacterClassEnum->GetValueByNameString(GetParam(TEXT("AttackerClass"), TEXT("Elementalist")));
+	const int64 DefenderClassValue = CharacterClassEnum->GetValueByNameString(GetParam(TEXT("DefenderClass"), TEXT("Warrior")));
+	const FCharacterClassDefaultInfo* AttackerClassInfo = AttackerClassValue != INDEX_NONE ? CharacterClassInfo->CharacterClassInformation.Find(static_cast<ECharacterClass>(AttackerClassValue)) : nullptr;
+	const FCharacterClassDefaultInfo* DefenderClassInfo = DefenderClassValue != INDEX_NONE ? CharacterClassInfo->CharacterClassInformation.Find(static_cast<ECharacterClass>(DefenderClassValue)) : nullptr;
+	if (AttackerClassInfo == nullptr || DefenderClassInfo == nullptr || CharacterClassInfo->SecondaryAttributes == nullptr) {
+		UE_LOG(LogAura, Error, TEXT("AuraDamageSim: Unknown AttackerClass or DefenderClass, or ClassInfo has no Secondary Attributes Effect"));
+		return 1;
+	}
+
+	// Simulation settings
+	const int32 MinLevel = FMath::Max(1, FCString::Atoi(*GetParam(TEXT("MinLevel"), TEXT("1"))));
+	const int32 MaxLevel = FMath::Max(MinLevel, FCString::Atoi(*GetParam(TEXT("MaxLevel"), TEXT("40"))));
+	const int32 FixedAbilityLevel = FCString::Atoi(*GetParam(TEXT("AbilityLevel"), TEXT("0"))); // 0 = use the Attacker's Level
+	const int32 NumSamples = FMath::Max(1, FCString::Atoi(*GetParam(TEXT("Samples"), TEXT("10000"))));
+	const float AttacksPerSecond = FCString::Atof(*GetParam(TEXT("AttacksPerSecond"), TEXT("1")));
+	const FString OutputPath = GetParam(TEXT("Output"), FPaths::ProjectSavedDir() / TEXT("DamageSim.csv"));
+	FRandomStream CombatStream(FCString::Atoi(*GetParam(TEXT("Seed"), TEXT("1"))));
+
+	FString Csv = TEXT("AttackerLevel,DefenderLevel,AbilityLevel,ExpectedDPS,MeanDamage,StdDevDamage,MinDamage,P10Damage,P50Damage,P90Damage,MaxDamage,BlockRate,CriticalHitRate\n");
+	TArray<float> Samples;
+	Samples.SetNumUninitialized(NumSamples);
+	FAuraDamageBatch DamageBatch;
+	DamageBatch.SetNum(NumSamples);
+	TArray<FAuraDamageResult> DamageResults;
+	DamageResults.SetNum(NumSamples);
+	TArray<FRandomStream> SampleStreams;
+	SampleStreams.SetNum(NumSamples);
+
+	// Transient AbilitySystemComponent the Modifier magnitudes are calculated against, so they go through the same GAS code as at runtime
+	UAbilitySystemComponent* SimulationASC = NewObject<UAbilitySystemComponent>(GetTransientPackage());
+	SimulationASC->AddSpawnedAttribute(NewObject<UAuraAttributeSet>(SimulationASC));
+
+	// Attributes of every Level from the same Effects InitializeDefaultAttributes applies: Primary first, Secondary based on them
+	TArray<TMap<FGameplayAttribute, float>> AttackerAttributes;
+	TArray<TMap<FGameplayAttribute, float>> DefenderAttributes;
+	AttackerAttributes.SetNum(MaxLevel + 1);
+	DefenderAttributes.SetNum(MaxLevel + 1);
+	for (int32 Level = MinLevel; Level <= MaxLevel; Level++) {
+		ApplyEffectDefaults(AttackerClassInfo->PrimaryAttributes, Level, SimulationASC, AttackerAttributes[Level]);
+		ApplyEffectDefaults(CharacterClassInfo->SecondaryAttributes, Level, SimulationASC, AttackerAttributes[Level]);
+		ApplyEffectDefaults(DefenderClassInfo->PrimaryAttributes, Level, SimulationASC, DefenderAttributes[Level]);
+		ApplyEffectDefaults(CharacterClassInfo->SecondaryAttributes, Level, SimulationASC, DefenderAttributes[Level]);
+	}
+	const FGameplayAttribute ResistanceAttributes[] = {
+		UAuraAttributeSet::GetFireResistanceAttribute(),
+		UAuraAttributeSet::GetLightningResistanceAttribute(),
+		UAuraAttributeSet::GetArcaneResistanceAttribute(),
+		UAuraAttributeSet::GetPhysicalResistanceAttribute()
+	};
+
+	for (int32 AttackerLevel = MinLevel; AttackerLevel <= MaxLevel; AttackerLevel++) {
+		for (int32 DefenderLevel = MinLevel; DefenderLevel <= MaxLevel; DefenderLevel++) {
+			const int32 AbilityLevel = FixedAbilityLevel > 0 ? FixedAbilityLevel : AttackerLevel;
+
+			// Build the same inputs UDamageExecCalc captures at runtime
+			FAuraDamageInputs DamageInputs;
+			for (const TPair<FGameplayTag, FScalableFloat>& Pair : Ability->GetDamageTypes()) {
+				const EAuraDamageType DamageType = GameplayTags.GetDamageTypeIndex(Pair.Key);
+				if (DamageType != EAuraDamageType::Num) {
+					DamageInputs.DamageByType[static_cast<int32>(DamageType)] = Pair.Value.GetValueAtLevel(AbilityLevel);
+				}
+			}
+			const TMap<FGameplayAttribute, float>& Attacker = AttackerAttributes[AttackerLevel];
+			const TMap<FGameplayAttribute, float>& Defender = DefenderAttributes[DefenderLevel];
+			for (int32 TypeIndex = 0; TypeIndex < static_cast<int32>(EAuraDamageType::Num); TypeIndex++) {
+				DamageInputs.ResistanceByType[TypeIndex] = Defender.FindRef(ResistanceAttributes[TypeIndex]);
+			}
+			DamageInputs.TargetBlockChance = Defender.FindRef(UAuraAttributeSet::GetBlockChanceAttribute());
+			DamageInputs.TargetArmor = Defender.FindRef(UAuraAttributeSet::GetArmorAttribute());
+			DamageInputs.TargetCriticalHitResistance = Defender.FindRef(UAuraAttributeSet::GetCriticalHitResistanceAttribute());
+			DamageInputs.SourceArmorPenetration = Attacker.FindRef(UAuraAttributeSet::GetArmorPenetrationAttribute());
+			DamageInputs.SourceCriticalHitChance = Attacker.FindRef(UAuraAttributeSet::GetCriticalHitChanceAttribute());
+			DamageInputs.SourceCriticalHitDamage = Attacker.FindRef(UAuraAttributeSet::GetCriticalHitDamageAttribute());
+			DamageInputs.ArmorPenetrationCoefficient = CharacterClassInfo->GetDamageCoefficient(EDamageCoefficient::ArmorPenetration, AttackerLevel);
+			DamageInputs.EffectiveArmorCoefficient = CharacterClassInfo->GetDamageCoefficient(EDamageCoefficient::EffectiveArmor, DefenderLevel);
+			DamageInputs.CriticalHitResistanceCoefficient = CharacterClassInfo->GetDamageCoefficient(EDamageCoefficient::CriticalHitResistance, DefenderLevel);
+
+			// Simulate hits with the batch kernel, every sample is one Target with its own Stream like at runtime
+			for (int32 SampleIndex = 0; SampleIndex < NumSamples; SampleIndex++) {
+				DamageBatch.SetTarget(SampleIndex, DamageInputs);
+				SampleStreams[SampleIndex].Initialize(static_cast<int32>(CombatStream.GetUnsignedInt()));
+			}
+			FAuraDamageMath::CalculateDamageBatch(DamageBatch, SampleStreams, DamageResults);
+
+			double DamageSum = 0.0;
+			double DamageSquaredSum = 0.0;
+			int32 NumBlocked = 0;
+			int32 NumCritical = 0;
+			for (int32 SampleIndex = 0; SampleIndex < NumSamples; SampleIndex++) {
+				const FAuraDamageResult& DamageResult = DamageResults[SampleIndex];
+				Samples[SampleIndex] = DamageResult.Damage;
+				DamageSum += DamageResult.Damage;
+				DamageSquaredSum += DamageResult.Damage * DamageResult.Damage;
+				NumBlocked += DamageResult.bBlockedHit ? 1 : 0;
+				NumCritical += DamageResult.bCriticalHit ? 1 : 0;
+			}
+
+			// Distribution
+			Samples.Sort();
+			auto Percentile = [&Samples](float Fraction) {
+				return Samples[FMath::Clamp(FMath::FloorToInt(Fraction * (Samples.Num() - 1)), 0, Samples.Num() - 1)];
+			};
+			const double Mean = DamageSum / NumSamples;
+			const double StdDev = FMath::Sqrt(FMath::Max(0.0, DamageSquaredSum / NumSamples - Mean * Mean));
+
+			Csv += FString::Printf(TEXT("%d,%d,%d,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n"),
+				AttackerLevel, DefenderLevel, AbilityLevel,
+				Mean * AttacksPerSecond, Mean, StdDev,
+				Samples[0], Percentile(.1f), Percentile(.5f), Percentile(.9f), Samples.Last(),
+				static_cast<float>(NumBlocked) / NumSamples, static_cast<float>(NumCritical) / NumSamples
+			);
+		}
+	}
+
+	if (!FFileHelper::SaveStringToFile(Csv, *OutputPath)) {
+		UE_LOG(LogAura, Error, TEXT("AuraDamageSim: Failed to write [%s]"), *OutputPath);
+		return 1;
+	}
+
+	const int32 NumLevels = MaxLevel - MinLevel + 1;
+	UE_LOG(LogAura, Display, TEXT("AuraDamageSim: Simulated %lld hits for %d Level pairs of [%s] (%s vs %s), written to [%s]"),
+		static_cast<int64>(NumLevels) * NumLevels * NumSamples, NumLevels * NumLevels, *AbilityClass->GetName(),
+		*CharacterClassEnum->GetNameStringByValue(AttackerClassValue), *CharacterClassEnum->GetNameStringByValue(DefenderClassValue), *OutputPath);
+	return 0;
+}
+
+void UAuraDamageSimCommandlet::ApplyEffectDefaults(TSubclassOf<UGameplayEffect> Effect, float Level, UAbilitySystemComponent* SimulationASC, TMap<FGameplayAttribute, float>& InOutAttributes)
+{
+	if (Effect == nullptr) return;
+	const UGameplayEffect* EffectCDO = Effect->GetDefaultObject<UGameplayEffect>();
+
+	// Load the Attributes from before this Effect into the AbilitySystemComponent
+	TArray<FGameplayAttribute> AllAttributes;
+	UAttributeSet::GetAttributesFromSetClass(UAuraAttributeSet::StaticClass(), AllAttributes);
+	for (const FGameplayAttribute& Attribute : AllAttributes) {
+		SimulationASC->SetNumericAttributeBase(Attribute, InOutAttributes.FindRef(Attribute));
+	}
+
+	// The Effect's own Spec, capturing its backing Attributes as both Source and Target like InitializeDefaultAttributes does
+	FGameplayEffectSpec Spec(EffectCDO, FGameplayEffectContextHandle(UAbilitySystemGlobals::Get().AllocGameplayEffectContext()), Level);
+	Spec.CapturedRelevantAttributes.CaptureAttributes(SimulationASC, EGameplayEffectAttributeCaptureSource::Source);
+	Spec.CapturedRelevantAttributes.CaptureAttributes(SimulationASC, EGameplayEffectAttributeCaptureSource::Target);
+
+	struct FAttributeAggregate
+	{
+		float Additive = 0.f;
+		float Multiplicative = 1.f;
+		float Division = 1.f;
+		TOptional<float> Override;
+	};
+
+	// Every Modifier is evaluated against the Attributes from before this Effect, like the captures of a single Spec
+	TMap<FGameplayAttribute, FAttributeAggregate> Aggregates;
+	for (const FGameplayModifierInfo& Modifier : EffectCDO->Modifiers) {
+		// MMCs read the Source Actor and Set By Caller magnitudes are set by the caller, neither exists offline
+		const EGameplayEffectMagnitudeCalculation CalculationType = Modifier.ModifierMagnitude.GetMagnitudeCalculationType();
+		if (CalculationType != EGameplayEffectMagnitudeCalculation::ScalableFloat && CalculationType != EGameplayEffectMagnitudeCalculation::AttributeBased) {
+			static TSet<FString> SkippedModifiers; // log each once, not for every Level
+			bool bAlreadySkipped = false;
+			SkippedModifiers.Add(Effect->GetName() + Modifier.Attribute.GetName(), &bAlreadySkipped);
+			if (bAlreadySkipped) continue;
+
+			UE_LOG(LogAura, Warning, TEXT("AuraDamageSim: Skipping the %s Modifier of [%s] on [%s], only Scalable Float and Attribute Based magnitudes are simulated"),
+				*StaticEnum<EGameplayEffectMagnitudeCalculation>()->GetNameStringByValue(static_cast<int64>(CalculationType)), *Modifier.Attribute.GetName(), *Effect->GetName());
+			continue;
+		}
+
+		float Magnitude = 0.f;
+		if (!Modifier.ModifierMagnitude.AttemptCalculateMagnitude(Spec, Magnitude)) {
+			UE_LOG(LogAura, Warning, TEXT("AuraDamageSim: Failed to calculate the Modifier of [%s] on [%s], skipping it"), *Modifier.Attribute.GetName(), *Effect->GetName());
+			continue;
+		}
+
+		// Same sums as FAggregatorModChannel: Multiplicative and Division Modifiers are biased by 1
+		FAttributeAggregate& Aggregate = Aggregates.FindOrAdd(Modifier.Attribute);
+		switch (Modifier.ModifierOp) {
+		case EGameplayModOp::Additive:
+			Aggregate.Additive += Magnitude;
+			break;
+		case EGameplayModOp::Multiplicitive:
+			Aggregate.Multiplicative += Magnitude - 1.f;
+			break;
+		case EGameplayModOp::Division:
+			Aggregate.Division += Magnitude - 1.f;
+			break;
+		case EGameplayModOp::Override:
+			Aggregate.Override = Magnitude;
+			break;
+		default:
+			break;
+		}
+	}
+
+	for (const TPair<FGameplayAttribute, FAttributeAggregate>& Pair : Aggregates) {
+		const FAttributeAggregate& Aggregate = Pair.Value;
+		if (Aggregate.Override.IsSet()) {
+			InOutAttributes.Add(Pair.Key, Aggregate.Override.GetValue());
+			continue;
+		}
+
+		const float Division = FMath::IsNearlyZero(Aggregate.Division) ? 1.f : Aggregate.Division; // GAS ignores a Division by 0 too
+		InOutAttributes.Add(Pair.Key, (InOutAttributes.FindRef(Pair.Key) + Aggregate.Additive) * Aggregate.Multiplicative / Division);
+	}
+}
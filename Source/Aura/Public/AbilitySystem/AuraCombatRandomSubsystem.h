@@ -0,0 +1,84 @@
+// Copyright Milán Amrein
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AuraCombatRandomSubsystem.generated.h"
+
+struct FGameplayEffectContextHandle;
+
+/**
+ * Kinds of combat rolls made for a Target of a Damage Spec. Each draws from its own Stream,
+ * so the order in which they are rolled never changes their outcome.
+ */
+enum class EAuraCombatRoll : uint8
+{
+	Damage, // Block & Critical Hit
+	Debuff,
+	Knockback
+};
+
+/**
+ * World Subsystem handing out Random Streams for combat rolls (Block, Critical Hit, Debuff, Knockback, Loot, Summons).
+ * Every Damage Spec gets a seed from the World's base seed, its Instigator and the number of Specs that Instigator made before,
+ * and each Target of the Spec rolls from that seed and its own name. Fixing the base seed with Aura.Combat.RandomSeed
+ * therefore replays a session exactly, independently of other Worlds and of the order Targets are processed in.
+ */
+UCLASS()
+class AURA_API UAuraCombatRandomSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/// <summary>
+	/// Function to give a Damage Context its seed, unless it already has one
+	/// </summary>
+	/// <param name="EffectContextHandle">Context of the Damage Spec</param>
+	static void AssignSpecSeed(FGameplayEffectContextHandle& EffectContextHandle);
+
+	/// <summary>
+	/// Function to create the Random Stream of one kind of roll for one Target of a Damage Spec.
+	/// Assigns the Spec's seed first if the Context has none yet.
+	/// </summary>
+	/// <param name="EffectContextHandle">Context of the Damage Spec</param>
+	/// <param name="Target">Target the roll is made for</param>
+	/// <param name="Roll">Kind of roll</param>
+	/// <returns>Random Stream seeded from the Spec's seed, the Target and the kind of roll</returns>
+	static FRandomStream MakeCombatStream(FGameplayEffectContextHandle& EffectContextHandle, const AActor* Target, EAuraCombatRoll Roll);
+
+	/// <summary>
+	/// Function to create a Random Stream for a roll that doesn't belong to a Damage Spec (e.g. Loot or Summons)
+	/// </summary>
+	/// <param name="WorldContextObject">Object of the World the roll is made in</param>
+	/// <param name="Source">Actor making the roll, can be null</param>
+	/// <returns>Random Stream seeded from the World's base seed, the Source and the number of rolls it made before</returns>
+	static FRandomStream MakeCombatStream(const UObject* WorldContextObject, const AActor* Source);
+
+	/// <summary>
+	/// Function to reset the base seed and the roll counters
+	/// </summary>
+	/// <param name="InSeed">New base seed, 0 for a random base seed</param>
+	void Reseed(int32 InSeed);
+
+private:
+
+	/// <summary>
+	/// Function to get the next seed of a Source and advance its counter
+	/// </summary>
+	uint32 NextSeed(const AActor* Source);
+
+	/// <summary>
+	/// Seed all Streams of this World are derived from
+	/// </summary>
+	uint32 BaseSeed = 0;
+
+	/// <summary>
+	/// Number of seeds handed out to each Source since the last reseed, keyed by the hash of the Source's name
+	/// </summary>
+	TMap<uint32, uint32> SeedCountBySource;
+
+};
@@ -0,0 +1,131 @@
+// Copyright Milán Amrein
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+/**
+ * Compact record of a single Damage event applied on the server
+ */
+struct FAuraDamageEventRecord
+{
+	/** Flags describing the outcome of the hit */
+	enum EFlags : uint8
+	{
+		Blocked = 1 << 0,
+		Critical = 1 << 1,
+		Debuff = 1 << 2,
+		Fatal = 1 << 3
+	};
+
+	/** FPlatformTime::Seconds() when the Damage was applied */
+	double Timestamp = 0.0;
+
+	/** UObject unique IDs of the Source and Target Avatars */
+	uint32 SourceId = 0;
+	uint32 TargetId = 0;
+
+	/** Serial numbers of the Source and Target Avatars, telling them apart from later objects reusing the same ID */
+	int32 SourceSerialNumber = 0;
+	int32 TargetSerialNumber = 0;
+
+	/** Damage before and after the Damage formula (Resistances, Block, Armor, Critical Hit) */
+	float RawDamage = 0.f;
+	float MitigatedDamage = 0.f;
+
+	/** EAuraDamageType of the Damage, EAuraDamageType::Num if unknown */
+	uint8 DamageTypeIndex = 0;
+
+	/** Combination of EFlags */
+	uint8 Flags = 0;
+
+	/// <summary>
+	/// Function to get the unique ID and serial number identifying an object in the records
+	/// </summary>
+	/// <param name="Object">Object to identify, may be null</param>
+	/// <param name="OutId">Unique ID of the object, 0 if null</param>
+	/// <param name="OutSerialNumber">Serial number of the object, 0 if null</param>
+	static void GetObjectId(const UObject* Object, uint32& OutId, int32& OutSerialNumber);
+
+	/// <summary>
+	/// Function to serialize a record field by field, so the binary dump doesn't depend on the struct's padding
+	/// </summary>
+	friend FArchive& operator<<(FArchive& Ar, FAuraDamageEventRecord& Record);
+};
+
+/**
+ * Fixed-capacity ring buffer of the latest Damage events on the server.
+ * Writing is an uncontended lock and a copy, so it is cheap enough to leave on in shipping servers.
+ * Readers take the same lock, so a snapshot never contains a record that is being overwritten.
+ * Inspected with the Aura.DamageLog.* console commands.
+ */
+class AURA_API FAuraDamageEventLog
+{
+public:
+
+	/** Number of records kept, must be a power of 2 */
+	static constexpr int32 Capacity = 8192;
+
+	/// <summary>
+	/// Function to return the one and only Damage event log
+	/// </summary>
+	static FAuraDamageEventLog& Get();
+
+	/// <summary>
+	/// Function to add a record, overwriting the oldest one when the buffer is full
+	/// </summary>
+	void Record(const FAuraDamageEventRecord& InRecord);
+
+	/// <summary>
+	/// Function to copy the buffered records, oldest first
+	/// </summary>
+	void Snapshot(TArray<FAuraDamageEventRecord>& OutRecords) const;
+
+	/// <summary>
+	/// Function to drop all buffered records
+	/// </summary>
+	void Clear();
+
+	/// <summary>
+	/// Function to return whether or not Damage events should be recorded (Aura.DamageLog.Enabled)
+	/// </summary>
+	static bool IsEnabled();
+
+private:
+
+	FAuraDamageEventLog();
+
+	/// <summary>
+	/// Function to write the buffered records as CSV
+	/// </summary>
+	bool DumpCsv(const FString& FilePath) const;
+
+	/// <summary>
+	/// Function to write the buffered records as a little endian binary file: header (magic, version, record count)
+	/// followed by the records, field by field in declaration order
+	/// </summary>
+	bool DumpBinary(const FString& FilePath) const;
+
+	/// <summary>
+	/// Function to log hits per second, the mitigation distribution and the Sources dealing the most Damage
+	/// </summary>
+	void LogStats() const;
+
+	/// <summary>
+	/// Records, indexed by write count modulo Capacity
+	/// </summary>
+	TArray<FAuraDamageEventRecord> Records;
+
+	/// <summary>
+	/// Total number of records written since the last Clear
+	/// </summary>
+	uint64 NumWritten = 0;
+
+	/// <summary>
+	/// Guards Records and NumWritten, Damage can be recorded while the log is being read
+	/// </summary>
+	mutable FCriticalSection RecordsCriticalSection;
+
+	friend struct FAuraDamageEventLogCommands;
+};
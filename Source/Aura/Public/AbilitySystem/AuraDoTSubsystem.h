@@ -0,0 +1,115 @@
+// Copyright Milán Amrein
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameplayTagContainer.h"
+#include "ActiveGameplayEffectHandle.h"
+#include "AbilitySystem/Data/DebuffInfo.h"
+#include "AuraDoTSubsystem.generated.h"
+
+class UAbilitySystemComponent;
+class UGameplayEffect;
+
+/**
+ * Struct for a single active Damage over Time (e.g. Burn)
+ */
+struct FAuraDoTEntry
+{
+	TWeakObjectPtr<UAbilitySystemComponent> TargetASC;
+	TWeakObjectPtr<UAbilitySystemComponent> SourceASC;
+
+	/** Debuff Gameplay Effect granting the Debuff Tag, the DoT ends when it is removed */
+	FActiveGameplayEffectHandle DebuffHandle;
+
+	FGameplayTag DamageType;
+	float Damage = 0.f;
+	float Period = 0.f;
+	float NextTickTime = 0.f;
+	float EndTime = 0.f;
+};
+
+/**
+ * Server-side World Subsystem ticking every Damage over Time in a single pass per frame.
+ * Debuff Gameplay Effects only grant the Debuff Tags; their periodic Damage is applied from here,
+ * summed per Target, Source and Damage Type, through one IncomingDamage execution each.
+ * Also owns the Debuff Gameplay Effects themselves, built once per Damage Type.
+ */
+UCLASS()
+class AURA_API UAuraDoTSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/// <summary>
+	/// Function to start a Damage over Time. The first tick happens on the next Subsystem tick.
+	/// Adding a DoT with the Debuff Handle of an active one (a refreshed stack) extends it and updates its Damage, keeping its next tick.
+	/// </summary>
+	/// <param name="SourceASC">AbilitySystemComponent of the Debuff causer</param>
+	/// <param name="TargetASC">AbilitySystemComponent of the Debuffed Target</param>
+	/// <param name="DebuffHandle">Handle of the Debuff Gameplay Effect, the DoT ends when it is removed</param>
+	/// <param name="DamageType">Damage Type of the Debuff</param>
+	/// <param name="Damage">Damage of each tick</param>
+	/// <param name="Period">Seconds between ticks</param>
+	/// <param name="Duration">Seconds the DoT is active for</param>
+	void AddDoT(UAbilitySystemComponent* SourceASC, UAbilitySystemComponent* TargetASC, FActiveGameplayEffectHandle DebuffHandle, const FGameplayTag& DamageType, float Damage, float Period, float Duration);
+
+	/// <summary>
+	/// Function to return the number of active DoTs
+	/// </summary>
+	int32 GetNumDoTs() const { return DoTs.Num(); }
+
+	/// <summary>
+	/// Function to return the Debuff Gameplay Effect of a Damage Type, built on first use.
+	/// It grants the Debuff Tag for the Set By Caller Debuff_Info_Duration magnitude of its Spec,
+	/// and stacks once per Target according to the Debuff's policy.
+	/// </summary>
+	/// <param name="DamageType">Damage Type of the Debuff</param>
+	/// <param name="Policy">Stacking policy of the Debuff, only read when the Effect is built</param>
+	/// <returns>The Debuff Gameplay Effect or nullptr if DamageType is not a Damage Type</returns>
+	UGameplayEffect* GetDebuffEffect(const FGameplayTag& DamageType, const FAuraDebuffPolicy& Policy);
+
+#if !UE_BUILD_SHIPPING
+	/// <summary>
+	/// Function to log the active Debuff Effects and stacks of every debuffed Target (Aura.Debuff.Stats)
+	/// </summary>
+	void LogDebuffStats() const;
+#endif
+
+private:
+
+	/// <summary>
+	/// Function to apply the summed tick Damage of one Target, Source and Damage Type through IncomingDamage
+	/// </summary>
+	void ApplyDoTDamage(UAbilitySystemComponent* SourceASC, UAbilitySystemComponent* TargetASC, const FGameplayTag& DamageType, float Damage);
+
+	/// <summary>
+	/// Whether or not the World is not a client's, set when play begins. Client Worlds never hold DoTs.
+	/// </summary>
+	bool bIsServerWorld = true;
+
+	/// <summary>
+	/// Active DoTs, kept flat and unordered so the tick is a single linear pass
+	/// </summary>
+	TArray<FAuraDoTEntry> DoTs;
+
+	/// <summary>
+	/// Instant Gameplay Effect adding a Set By Caller magnitude to IncomingDamage, shared by all DoT ticks
+	/// </summary>
+	UPROPERTY()
+	TObjectPtr<UGameplayEffect> DoTDamageEffect;
+
+	/// <summary>
+	/// Debuff Gameplay Effects indexed by EAuraDamageType
+	/// </summary>
+	UPROPERTY()
+	TArray<TObjectPtr<UGameplayEffect>> DebuffEffects;
+
+};
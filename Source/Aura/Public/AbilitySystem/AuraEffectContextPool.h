@@ -0,0 +1,87 @@
+// Copyright Milán Amrein
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AuraAbilityTypes.h"
+#include "Containers/LockFreeFixedSizeAllocator.h"
+#include <atomic>
+
+/** Whether or not freed contexts are kept in per-thread bundles before going back to the shared free list */
+#ifndef AURA_EFFECT_CONTEXT_POOL_TLS_CACHE
+#define AURA_EFFECT_CONTEXT_POOL_TLS_CACHE 1
+#endif
+
+/** Whether or not the pool counts live, peak and allocated contexts. The counters are shared by all threads, so they are left out of shipping */
+#ifndef AURA_EFFECT_CONTEXT_POOL_STATS
+#define AURA_EFFECT_CONTEXT_POOL_STATS !UE_BUILD_SHIPPING
+#endif
+
+/**
+ * Thread-safe fixed-size block pool for FAuraGameplayEffectContext.
+ * Every spec, cue and prediction allocates a context, so freed blocks are recycled instead of going back to the global allocator.
+ * Used through FAuraGameplayEffectContext's operator new / delete, inspected with the Aura.EffectContextPool.* console commands outside of shipping.
+ */
+class AURA_API FAuraEffectContextPool
+{
+public:
+
+	/** Size of a block, a whole FAuraGameplayEffectContext */
+	static constexpr int32 BlockSize = Align(sizeof(FAuraGameplayEffectContext), 16);
+
+	/// <summary>
+	/// Function to return the one and only Effect Context pool
+	/// </summary>
+	static FAuraEffectContextPool& Get();
+
+	/// <summary>
+	/// Function to take a block of BlockSize bytes from the pool
+	/// </summary>
+	void* Allocate();
+
+	/// <summary>
+	/// Function to give a block taken with Allocate back to the pool
+	/// </summary>
+	void Free(void* Block);
+
+#if AURA_EFFECT_CONTEXT_POOL_STATS
+	/** Number of contexts currently alive */
+	int64 GetNumLive() const { return NumLive.load(std::memory_order_relaxed); }
+
+	/** Highest number of contexts alive at the same time */
+	int64 GetPeakLive() const { return PeakLive.load(std::memory_order_relaxed); }
+
+	/** Total number of contexts allocated */
+	int64 GetNumAllocations() const { return NumAllocations.load(std::memory_order_relaxed); }
+#endif
+
+private:
+
+	FAuraEffectContextPool();
+
+#if !UE_BUILD_SHIPPING
+	/// <summary>
+	/// Function to log the live, peak and total context counts
+	/// </summary>
+	void LogStats() const;
+
+	/// <summary>
+	/// Function to allocate and free NumContexts contexts through the pool and through plain FMemory, then log both timings
+	/// </summary>
+	static void RunBenchmark(int32 NumContexts);
+#endif
+
+#if AURA_EFFECT_CONTEXT_POOL_TLS_CACHE
+	TLockFreeFixedSizeAllocator_TLSCache<BlockSize> Allocator;
+#else
+	TLockFreeFixedSizeAllocator<BlockSize, PLATFORM_CACHE_LINE_SIZE> Allocator;
+#endif
+
+#if AURA_EFFECT_CONTEXT_POOL_STATS
+	std::atomic<int64> NumLive;
+	std::atomic<int64> PeakLive;
+	std::atomic<int64> NumAllocations;
+#endif
+
+	friend struct FAuraEffectContextPoolCommands;
+};
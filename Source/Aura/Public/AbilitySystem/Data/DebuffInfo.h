@@ -0,0 +1,70 @@
+// Copyright Milán Amrein
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "GameplayTagContainer.h"
+#include "DebuffInfo.generated.h"
+
+/// <summary>
+/// What happens when a Debuff is applied to a Target that already has it
+/// </summary>
+UENUM(BlueprintType)
+enum class EDebuffStackingPolicy : uint8
+{
+	RefreshDuration UMETA(DisplayName = "Refresh Duration"),
+	StackMagnitude UMETA(DisplayName = "Stack Magnitude"),
+	IgnoreWhileActive UMETA(DisplayName = "Ignore While Active")
+};
+
+/// <summary>
+/// Stacking and refresh policy of a Debuff
+/// </summary>
+USTRUCT(BlueprintType)
+struct FAuraDebuffPolicy
+{
+	GENERATED_BODY()
+
+	/// <summary>
+	/// Debuff the policy applies to
+	/// </summary>
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (Categories = "Debuff"))
+	FGameplayTag DebuffTag = FGameplayTag();
+
+	/// <summary>
+	/// What happens when the Target already has the Debuff
+	/// </summary>
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	EDebuffStackingPolicy StackingPolicy = EDebuffStackingPolicy::RefreshDuration;
+
+	/// <summary>
+	/// Maximum number of stacks, each adding the Debuff Damage once. Only used by StackMagnitude.
+	/// </summary>
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (ClampMin = 1, EditCondition = "StackingPolicy == EDebuffStackingPolicy::StackMagnitude"))
+	int32 MaxStacks = 1;
+};
+
+/**
+ * Data Asset class for storing the stacking and refresh policy of each Debuff
+ */
+UCLASS()
+class AURA_API UDebuffInfo : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	/// <summary>
+	/// Policies of the Debuffs, Debuffs without one refresh their duration
+	/// </summary>
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "DebuffInformation")
+	TArray<FAuraDebuffPolicy> DebuffPolicies;
+
+	/// <summary>
+	/// Function to retrieve the policy of a Debuff
+	/// </summary>
+	/// <param name="DebuffTag">Debuff Tag to find the policy for</param>
+	/// <returns>The policy of the Debuff or a RefreshDuration policy if none is set</returns>
+	FAuraDebuffPolicy FindDebuffPolicyForTag(const FGameplayTag& DebuffTag) const;
+};
@@ -0,0 +1,136 @@
+// Copyright Milán Amrein
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AuraGameplayTags.h"
+
+/**
+ * Struct holding every value the Damage formula depends on.
+ * Attribute values are the raw captured magnitudes, clamping is done by FAuraDamageMath.
+ */
+struct FAuraDamageInputs
+{
+	/** Damage of each Damage Type from the Set By Caller magnitudes, indexed by EAuraDamageType */
+	float DamageByType[static_cast<int32>(EAuraDamageType::Num)] = {};
+
+	/** Target's Resistance to each Damage Type, indexed by EAuraDamageType */
+	float ResistanceByType[static_cast<int32>(EAuraDamageType::Num)] = {};
+
+	/** Scale of the Radial Damage based on the distance from its Origin, 1 if not Radial */
+	float RadialDamageFalloff = 1.f;
+
+	float TargetBlockChance = 0.f;
+	float TargetArmor = 0.f;
+	float SourceArmorPenetration = 0.f;
+	float SourceCriticalHitChance = 0.f;
+	float TargetCriticalHitResistance = 0.f;
+	float SourceCriticalHitDamage = 0.f;
+
+	/** Coefficients from UCharacterClassInfo::DamageCalculationCoefficients */
+	float ArmorPenetrationCoefficient = 0.f;
+	float EffectiveArmorCoefficient = 0.f;
+	float CriticalHitResistanceCoefficient = 0.f;
+};
+
+/**
+ * Struct holding the outcome of the Damage formula
+ */
+struct FAuraDamageResult
+{
+	float Damage = 0.f;
+	bool bBlockedHit = false;
+	bool bCriticalHit = false;
+};
+
+/**
+ * Struct of arrays holding the Damage inputs of many Targets, one element per Target.
+ * Used by FAuraDamageMath::CalculateDamageBatch to evaluate four Targets per SIMD instruction.
+ */
+struct AURA_API FAuraDamageBatch
+{
+	/// <summary>
+	/// Function to resize every array to the number of Targets
+	/// </summary>
+	void SetNum(int32 NumTargets);
+
+	/// <summary>
+	/// Function to copy the Damage inputs of a single Target into the arrays
+	/// </summary>
+	void SetTarget(int32 TargetIndex, const FAuraDamageInputs& Inputs);
+
+	/// <summary>
+	/// Function to gather the Damage inputs of a single Target from the arrays
+	/// </summary>
+	FAuraDamageInputs GetTarget(int32 TargetIndex) const;
+
+	int32 Num() const { return TargetArmor.Num(); }
+
+	TArray<float> DamageByType[static_cast<int32>(EAuraDamageType::Num)];
+	TArray<float> ResistanceByType[static_cast<int32>(EAuraDamageType::Num)];
+	TArray<float> RadialDamageFalloff;
+	TArray<float> TargetBlockChance;
+	TArray<float> TargetArmor;
+	TArray<float> SourceArmorPenetration;
+	TArray<float> SourceCriticalHitChance;
+	TArray<float> TargetCriticalHitResistance;
+	TArray<float> SourceCriticalHitDamage;
+	TArray<float> ArmorPenetrationCoefficient;
+	TArray<float> EffectiveArmorCoefficient;
+	TArray<float> CriticalHitResistanceCoefficient;
+};
+
+/**
+ * World-free implementation of the Damage formula.
+ * Shared by UDamageExecCalc and the offline Damage simulator, so the two can never drift apart.
+ */
+struct AURA_API FAuraDamageMath
+{
+	/// <summary>
+	/// Function to calculate the final Damage of a hit: Resistances, Block, Armor Penetration, Effective Armor and Critical Hit.
+	/// Rolls Block first and Critical Hit second from the given Stream.
+	/// </summary>
+	/// <param name="Inputs">Values the Damage formula depends on</param>
+	/// <param name="CombatStream">Random Stream to roll Block and Critical Hit from</param>
+	/// <returns>Final Damage and the outcome of the rolls</returns>
+	static FAuraDamageResult CalculateDamage(const FAuraDamageInputs& Inputs, FRandomStream& CombatStream);
+
+	/// <summary>
+	/// Function to calculate the final Damage of many Targets at once, four Targets per SIMD instruction.
+	/// Results are bit-exact with calling CalculateDamage for each Target with its own Stream.
+	/// </summary>
+	/// <param name="Batch">Damage inputs of all Targets</param>
+	/// <param name="CombatStreams">Random Stream of each Target to roll Block and Critical Hit from, must have Batch.Num() elements</param>
+	/// <param name="OutResults">Final Damage and the outcome of the rolls for each Target, must have Batch.Num() elements</param>
+	static void CalculateDamageBatch(const FAuraDamageBatch& Batch, TArrayView<FRandomStream> CombatStreams, TArrayView<FAuraDamageResult> OutResults);
+
+	/// <summary>
+	/// Function to sum the Damage of all Damage Types, reduced by the Target's Resistances and the Radial Damage falloff
+	/// </summary>
+	static float CalculateResistedDamage(const FAuraDamageInputs& Inputs);
+
+	/// <summary>
+	/// Function to reduce Damage by the Target's Armor, which is itself reduced by the Source's Armor Penetration
+	/// </summary>
+	static float ApplyArmor(float Damage, const FAuraDamageInputs& Inputs);
+
+	/// <summary>
+	/// Function to get the chance of a Critical Hit after the Target's Critical Hit Resistance
+	/// </summary>
+	static float GetEffectiveCriticalHitChance(const FAuraDamageInputs& Inputs);
+
+	/// <summary>
+	/// Function to roll a percentage chance, e.g. a chance of 25 succeeds if the roll is less than 26
+	/// </summary>
+	/// <param name="CombatStream">Random Stream to roll from</param>
+	/// <param name="Chance">Chance of success between 0 and 100</param>
+	/// <returns>Whether or not the roll succeeded</returns>
+	static bool RollChance(FRandomStream& CombatStream, float Chance);
+
+private:
+
+	/// <summary>
+	/// Function to calculate the final Damage of a hit from already rolled Block and Critical Hit values (1 to 100)
+	/// </summary>
+	static FAuraDamageResult CalculateDamageFromRolls(const FAuraDamageInputs& Inputs, float BlockRoll, float CriticalHitRoll);
+};
@@ -2,10 +2,71 @@
 
 #include "GameplayEffectTypes.h"
 #include "ScalableFloat.h"
+#include "AuraGameplayTags.h"
 #include "AuraAbilityTypes.generated.h"
 
 class UGameplayEffect;
 
+/// <summary>
+/// Inline map of Damage per Damage Type, keyed by EAuraDamageType.
+/// Stored inline, so copying Damage parameters around never allocates.
+/// Exposed to Blueprint through UAuraAbilitySystemLibrary.
+/// </summary>
+USTRUCT(BlueprintType)
+struct FAuraDamageTypeMap
+{
+	GENERATED_BODY()
+
+	/// <summary>
+	/// Function to set the Damage of a Damage Type Tag. Tags that are not Damage Types are reported and ignored.
+	/// </summary>
+	void Add(const FGameplayTag& DamageTypeTag, float Damage);
+
+	/// <summary>
+	/// Function to return the Damage of a Damage Type Tag, 0 if not set
+	/// </summary>
+	float Find(const FGameplayTag& DamageTypeTag) const;
+
+	/// <summary>
+	/// Function to return whether or not the Damage Type has been set
+	/// </summary>
+	bool Contains(EAuraDamageType DamageType) const { return (SetMask & (1 << static_cast<uint8>(DamageType))) != 0; }
+
+	/// <summary>
+	/// Function to return the Damage of a Damage Type, 0 if not set
+	/// </summary>
+	float Get(EAuraDamageType DamageType) const { return Damages[static_cast<uint8>(DamageType)]; }
+
+	/// <summary>
+	/// Function to call Func(DamageTypeTag, Damage) for every Damage Type that has been set
+	/// </summary>
+	template<typename FuncType>
+	void ForEach(FuncType Func) const
+	{
+		const FAuraGameplayTags& GameplayTags = FAuraGameplayTags::Get();
+		for (int32 TypeIndex = 0; TypeIndex < static_cast<int32>(EAuraDamageType::Num); TypeIndex++) {
+			if (Contains(static_cast<EAuraDamageType>(TypeIndex))) {
+				Func(GameplayTags.DamageTypeTags[TypeIndex], Damages[TypeIndex]);
+			}
+		}
+	}
+
+private:
+
+	/// <summary>
+	/// Damage of each Damage Type, indexed by EAuraDamageType
+	/// </summary>
+	UPROPERTY()
+	float Damages[4] = {};
+
+	/// <summary>
+	/// Bit for each Damage Type that has been set, so a Damage of 0 can still be assigned as a Set By Caller magnitude
+	/// </summary>
+	UPROPERTY()
+	uint8 SetMask = 0;
+};
+static_assert(static_cast<int32>(EAuraDamageType::Num) == 4, "FAuraDamageTypeMap::Damages must have one element per EAuraDamageType");
+
 /// <summary>
 /// Struct for storing Damage Effect parameters
 /// </summary>
@@ -41,10 +102,11 @@ struct FDamageEffectParams
 	TObjectPtr<UAbilitySystemComponent> TargetASC;
 
 	/// <summary>
-	/// What kind of Damage and how much Damage do we cause
+	/// What kind of Damage and how much Damage do we cause.
+	/// Set and read from Blueprint with UAuraAbilitySystemLibrary::SetDamageByTypeDamageEffectParam / GetDamageByTypeDamageEffectParam.
 	/// </summary>
-	UPROPERTY(BlueprintReadWrite)
-	TMap<FGameplayTag, float> Damages;
+	UPROPERTY()
+	FAuraDamageTypeMap Damages;
 
 	/// <summary>
 	/// Amount of impulse received upon death
@@ -133,16 +195,17 @@ struct FAuraGameplayEffectContext : public FGameplayEffectContext
 public:
 
 	/** Returns the actual struct used for serialization, subclasses must override this! */
-	virtual UScriptStruct* GetScriptStruct() const
+	virtual UScriptStruct* GetScriptStruct() const override
 	{
-		return FGameplayEffectContext::StaticStruct();
+		return FAuraGameplayEffectContext::StaticStruct();
 	}
 
 	/** Creates a copy of this context, used to duplicate for later modifications */
-	virtual FGameplayEffectContext* Duplicate() const
+	virtual FAuraGameplayEffectContext* Duplicate() const override
 	{
-		FGameplayEffectContext* NewContext = new FGameplayEffectContext();
+		FAuraGameplayEffectContext* NewContext = new FAuraGameplayEffectContext();
 		*NewContext = *this;
+		NewContext->bIsShared = false; // the copy belongs to whoever duplicated it
 		if (GetHitResult())
 		{
 			// Does a deep copy of the hit result
@@ -151,9 +214,28 @@ public:
 		return NewContext;
 	}
 
+	/** Contexts are allocated from FAuraEffectContextPool, since every spec, cue and prediction makes one */
+	static void* operator new(size_t Size);
+	static void operator delete(void* Block, size_t Size);
+
+	/** Placement new is still needed by UScriptStruct and containers */
+	static void* operator new(size_t Size, void* Place) { return Place; }
+	static void operator delete(void* Block, void* Place) {}
+
 	/** Custom serialization used to convert the struct to bits of data so it can be sent across the network */
 	virtual bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
 
+	/// <summary>
+	/// Version of the NetSerialize wire format, bump it whenever the format changes
+	/// </summary>
+	static constexpr uint8 NetSerializeVersion = 1;
+	static constexpr uint32 NetSerializeVersionBits = 4;
+
+	/// <summary>
+	/// Number of RepBits flags sent by NetSerialize
+	/// </summary>
+	static constexpr uint32 NetSerializeRepBits = 14;
+
 	/**
 	* Getters & Setters
 	*/
@@ -164,9 +246,16 @@ public:
 	float GetDebuffDamage() const { return DebuffDamage; }
 	float GetDebuffDuration() const { return DebuffDuration; }
 	float GetDebuffFrequency() const { return DebuffFrequency; }
-	TSharedPtr<FGameplayTag> GetDamageType() const { return DamageType; }
+	FGameplayTag GetDamageType() const
+	{
+		return DamageType != EAuraDamageType::Num ? FAuraGameplayTags::Get().DamageTypeTags[static_cast<uint8>(DamageType)] : FGameplayTag();
+	}
+	EAuraDamageType GetDamageTypeIndex() const { return DamageType; }
 	FVector GetDeathImpulse() const { return DeathImpulse; }
 	FVector GetKnockbackForce() const { return KnockbackForce; }
+	bool IsShared() const { return bIsShared; }
+	bool HasCombatSeed() const { return bHasCombatSeed; }
+	uint32 GetCombatSeed() const { return CombatSeed; }
 	bool IsRadialDamage() const { return bIsRadialDamage; }
 	float GetRadialDamageInnerRadius() const { return RadialDamageInnerRadius; }
 	float GetRadialDamageOuterRadius() const { return RadialDamageOuterRadius; }
@@ -178,9 +267,12 @@ public:
 	void SetDebuffDamage(float InDebuffDamage) { DebuffDamage = InDebuffDamage; }
 	void SetDebuffDuration(float InDebuffDuration) { DebuffDuration = InDebuffDuration; }
 	void SetDebuffFrequency(float InDebuffFrequency) { DebuffFrequency = InDebuffFrequency; }
-	void SetDamageType(TSharedPtr<FGameplayTag> InDamageType) { DamageType = InDamageType; }
+	void SetDamageType(const FGameplayTag& InDamageType) { DamageType = FAuraGameplayTags::Get().GetDamageTypeIndex(InDamageType); }
+	void SetDamageTypeIndex(EAuraDamageType InDamageType) { DamageType = InDamageType; }
 	void SetDeathImpulse(const FVector& InImpulse) { DeathImpulse = InImpulse; }
 	void SetKnockbackForce(const FVector& InForce) { KnockbackForce = InForce; }
+	void SetIsShared(bool bInIsShared) { bIsShared = bInIsShared; }
+	void SetCombatSeed(uint32 InCombatSeed) { CombatSeed = InCombatSeed; bHasCombatSeed = true; }
 	void SetIsRadialDamage(bool InIsRadialDamage) { bIsRadialDamage = InIsRadialDamage; }
 	void SetRadialDamageInnerRadius(float InRadialDamageInnerRadius) { RadialDamageInnerRadius = InRadialDamageInnerRadius; }
 	void SetRadialDamageOuterRadius(float InRadialDamageOuterRadius) { RadialDamageOuterRadius = InRadialDamageOuterRadius; }
@@ -206,7 +298,10 @@ protected:
 	UPROPERTY()
 	float DebuffFrequency = 0.f;
 
-	TSharedPtr<FGameplayTag> DamageType;
+	/// <summary>
+	/// Index of the native Damage Type Tag, EAuraDamageType::Num if none. Stored inline so setting it never allocates.
+	/// </summary>
+	EAuraDamageType DamageType = EAuraDamageType::Num;
 
 	UPROPERTY()
 	FVector DeathImpulse = FVector::ZeroVector;
@@ -217,6 +312,19 @@ protected:
 	UPROPERTY()
 	bool bIsRadialDamage = false;
 
+	/// <summary>
+	/// Whether or not the Context is applied to several Targets. Shared Contexts are copied before per Target hit results are written (copy-on-write).
+	/// Server only, never serialized.
+	/// </summary>
+	bool bIsShared = false;
+
+	/// <summary>
+	/// Seed of the combat rolls of this Spec, see UAuraCombatRandomSubsystem. Kept by copies of the Context,
+	/// so every Target of a shared Spec rolls from the same seed. Server only, never serialized.
+	/// </summary>
+	bool bHasCombatSeed = false;
+	uint32 CombatSeed = 0;
+
 	UPROPERTY()
 	float RadialDamageInnerRadius = 0.f;
 
@@ -0,0 +1,51 @@
+// Copyright Milán Amrein
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "AuraDamageSimCommandlet.generated.h"
+
+class UAbilitySystemComponent;
+class UGameplayEffect;
+struct FGameplayAttribute;
+
+/**
+ * Commandlet to simulate the Damage formula offline, without loading a map.
+ * Runs FAuraDamageMath (the same code as UDamageExecCalc) for every Attacker / Defender Level pair
+ * and writes the expected DPS and Damage distribution of each pair into a CSV.
+ *
+ * Attacker and Defender Attributes are derived the same way UAuraAbilitySystemLibrary::InitializeDefaultAttributes does:
+ * the Character Class' Primary Attributes Effect (CT_PrimaryAttributes_* Curve Tables) and the shared Secondary Attributes Effect,
+ * evaluated from the Effects' class defaults against a transient AbilitySystemComponent.
+ *
+ * Usage: UnrealEditor-Cmd Aura.uproject -run=AuraDamageSim -Ability=<AbilityClassPath>
+ *        [-AttackerClass=Elementalist] [-DefenderClass=Warrior] [-ClassInfo=<CharacterClassInfoPath>]
+ *        [-MinLevel=1] [-MaxLevel=40] [-AbilityLevel=N] [-Samples=10000] [-AttacksPerSecond=1] [-Seed=1] [-Output=<CsvPath>]
+ */
+UCLASS()
+class AURA_API UAuraDamageSimCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UAuraDamageSimCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+
+	/// <summary>
+	/// Function to apply the Modifiers of a Gameplay Effect's class defaults to a set of Attribute values,
+	/// aggregated the way GAS does: ((Base + Additive) * Multiplicative) / Division, or Override.
+	/// Magnitudes are calculated by GAS from a Spec of the Effect capturing the Attributes off SimulationASC.
+	/// Scalable Float and Attribute Based Modifiers are supported, others (MMCs, Set By Caller) are logged and skipped.
+	/// </summary>
+	/// <param name="Effect">Gameplay Effect Class to evaluate</param>
+	/// <param name="Level">Level the Effect is applied at</param>
+	/// <param name="SimulationASC">Transient AbilitySystemComponent with an Aura Attribute Set, its Attributes are overwritten</param>
+	/// <param name="InOutAttributes">Attribute values before the Effect, updated with the Attributes it modifies</param>
+	static void ApplyEffectDefaults(TSubclassOf<UGameplayEffect> Effect, float Level, UAbilitySystemComponent* SimulationASC, TMap<FGameplayAttribute, float>& InOutAttributes);
+
+};